@@ -0,0 +1,126 @@
+#!/usr/bin/env lua5.4
+-- Packs Lua modules into a script archive, which `LuaLoader_MountScriptArchive()`
+-- makes available to `require()`. See `src/shared/LuaLoader/utils/script_archive.h`
+-- for a description of the format.
+--
+-- Usage: lua5.4 pack_scripts.lua [--source|--bytecode|--both] OUTPUT ROOT FILE...
+--
+-- Module names are derived from the paths of the files relative to `ROOT`, the
+-- same way `package.path` maps them: `ROOT/foo/bar.lua` becomes `foo.bar`, and
+-- `ROOT/foo/init.lua` becomes `foo`. Bytecode is compiled by the Lua running
+-- this script, so it should be the same version the mod was built with; the
+-- mod falls back to the source (if it was packed) otherwise. For example:
+--
+--     find scripts -name '*.lua' -print0 | xargs -0 lua5.4 pack_scripts.lua --both scripts.pak scripts
+
+local assert = assert
+local error  = error
+local io     = io
+local ipairs = ipairs
+local load   = load
+local os     = os
+local print  = print
+local string = string
+local table  = table
+
+local MAGIC   = "LuaLPAK\0"
+local VERSION = 1
+local HEADER_SIZE = 16
+local ENTRY_SIZE  = 24
+
+local args = { ... }
+
+local mode = "both"
+if args[1] and args[1]:match("^%-%-") then
+	mode = table.remove(args, 1):sub(3)
+	if (mode ~= "source") and (mode ~= "bytecode") and (mode ~= "both") then
+		error(string.format("Unknown option %q!", "--" .. mode))
+	end
+end
+
+local output_path = args[1]
+local root = args[2]
+if (output_path == nil) or (root == nil) then
+	io.stderr:write("Usage: lua5.4 pack_scripts.lua [--source|--bytecode|--both] OUTPUT ROOT FILE...\n")
+	os.exit(1)
+end
+
+root = root:gsub("[/\\]+$", "")
+
+---@param path string
+---@return string
+local function get_module_name(path)
+	local relative_path = path:gsub("\\", "/")
+	local prefix = root:gsub("\\", "/") .. "/"
+	if relative_path:sub(1, #prefix) ~= prefix then
+		error(string.format("File %q is not inside of %q!", path, root))
+	end
+
+	local name = relative_path:sub(#prefix + 1):gsub("%.lua$", ""):gsub("/init$", ""):gsub("/", ".")
+
+	return name
+end
+
+---@type { name: string, source: string, bytecode: string }[]
+local entries = {}
+local seen = {}
+
+for i = 3, #args do
+	local path = args[i]
+	local name = get_module_name(path)
+	if seen[name] then
+		error(string.format("Both %q and %q map to the module %q!", seen[name], path, name))
+	end
+	seen[name] = path
+
+	local file <close> = assert(io.open(path, "rb"))
+	local source = assert(file:read("a"))
+
+	local bytecode = ""
+	if mode ~= "source" then
+		-- Keep the debug information, so that error messages still point at
+		-- the right lines. Shebang lines are blanked out the same way
+		-- `luaL_loadfilex()` would skip them.
+		local chunk = assert(load(source:gsub("^#[^\n]*", ""), "@" .. path, "t"))
+		bytecode = string.dump(chunk, false)
+	end
+
+	entries[#entries + 1] = {
+		name = name,
+		source = (mode ~= "bytecode") and source:gsub("^#[^\n]*", "") or "",
+		bytecode = bytecode,
+	}
+end
+
+table.sort(entries, function(a, b) return a.name < b.name end)
+
+local index = {}
+local blobs = {}
+local offset = HEADER_SIZE + (#entries * ENTRY_SIZE)
+
+---@param data string
+---@return integer offset, integer length
+local function add_blob(data)
+	local blob_offset = offset
+	blobs[#blobs + 1] = data
+	offset = offset + #data
+	return blob_offset, #data
+end
+
+for _, entry in ipairs(entries) do
+	local name_offset, name_length = add_blob(entry.name)
+	local source_offset, source_length = add_blob(entry.source)
+	local bytecode_offset, bytecode_length = add_blob(entry.bytecode)
+
+	index[#index + 1] = string.pack(
+		"<I4I4I4I4I4I4",
+		name_offset, name_length,
+		source_offset, source_length,
+		bytecode_offset, bytecode_length
+	)
+end
+
+local file <close> = assert(io.open(output_path, "wb"))
+assert(file:write(MAGIC, string.pack("<I4I4", VERSION, #entries), table.concat(index), table.concat(blobs)))
+
+print(string.format("Packed %d module(s) into %q (%d bytes).", #entries, output_path, offset))
@@ -113,6 +113,39 @@ sizeof(u64) = 8
 	LuaLoader_Deinit(SPLIT_DOUBLEWORD(L));
 } */
 
+// Created once and kept for the whole session, so that script globals survive
+// from one hook to the next. See `get_lua_handle()`.
+static LuaLoader_Handle lua_handle = 0;
+
+static void mount_script_archive(LuaLoader_Handle L) {
+	char *archive_path = recomp_get_config_string("LuaLoader::ScriptArchive");
+
+	if (archive_path == NULL) {
+		return;
+	}
+
+	if ((archive_path[0] != '\0') && !LuaLoader_MountScriptArchive(L, archive_path)) {
+		LOG("Failed to mount the script archive! Modules will only be searched for in `package.path`.");
+	}
+
+	recomp_free_config_string(archive_path);
+}
+
+static LuaLoader_Handle get_lua_handle(void) {
+	if (lua_handle == 0) {
+		lua_handle = LuaLoader_Init();
+
+		if (lua_handle == 0) {
+			LOG("Failed to create a Lua state!");
+			return 0;
+		}
+
+		mount_script_archive(lua_handle);
+	}
+
+	return lua_handle;
+}
+
 RECOMP_HOOK("Player_Init") void test_hook(Actor *thisx, PlayState *play) {
 	static bool do_run = true;
 	if (!do_run) return;
@@ -121,10 +154,9 @@ RECOMP_HOOK("Player_Init") void test_hook(Actor *thisx, PlayState *play) {
 	const char script_code[] = "If you can read this, it works!";
 	LOG("script_code["PRINTF_S32"] = "PRINTF_PTR, (s32)sizeof(script_code), script_code);
 
-	u64 L = LuaLoader_Init();
+	const LuaLoader_Handle L = get_lua_handle();
 
-	if (L == 0ULL) {
-		LOG("Expected `L` to be a pointer to `lua_State`, but got NULL instead!");
+	if (L == 0) {
 		return;
 	}
 
@@ -132,7 +164,7 @@ RECOMP_HOOK("Player_Init") void test_hook(Actor *thisx, PlayState *play) {
 
 	if (script_file_path == NULL) {
 		LOG("Failed to get the file path of the entrypoint Lua script!");
-		goto CleanupLuaVM;
+		return;
 	}
 
 	if (script_file_path[0] == '\0') {
@@ -148,15 +180,34 @@ RECOMP_HOOK("Player_Init") void test_hook(Actor *thisx, PlayState *play) {
 		sizeof(script_code) - 1, // Do not count the terminating NULL-byte.
 	};
 	LuaLoader_InvokeScriptCode(&invoke_script_args); */
-	LuaLoader_InvokeScriptFile(L, script_file_path);
+	LuaLoader_InvokeScriptFiles(L, script_file_path);
 
 CleanupScriptFilePath:
 	recomp_free_config_string(script_file_path);
 
-CleanupLuaVM:
-	LuaLoader_Deinit(L);
-
 	//LuaLoader_DumpRDRAM("/tmp/rdram-dump.bin", true);
+	//LuaLoader_DumpRDRAMSnapshot("/tmp/rdram-snapshot.bin", false);
+}
+
+// Runs the callbacks scripts registered with `Recomp.on("Player_Update", ...)`.
+// Does nothing until a script has been run, so that no Lua state gets created
+// just for this.
+RECOMP_HOOK("Player_Update") void dispatch_player_update(Actor *thisx, PlayState *play) {
+	static u32 hook_id = 0;
+
+	if (lua_handle == 0) {
+		return;
+	}
+
+	if (hook_id == 0) {
+		hook_id = LuaLoader_GetHookId(lua_handle, "Player_Update");
+
+		if (hook_id == 0) {
+			return;
+		}
+	}
+
+	LuaLoader_Dispatch(lua_handle, hook_id, (u32)thisx, (u32)play);
 }
 
 void print_actor_info(const Actor *restrict const thisx) {
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "./lua/src/lua.h"
 #include "./lua/src/lualib.h"
@@ -13,28 +14,30 @@
 
 #include "./utils/arguments.h"
 #include "./utils/array.h"
+#include "./utils/bytecode_cache.h"
+#include "./utils/dump_writer.h"
+#include "./utils/hooks.h"
 #include "./utils/logging.h"
 #include "./utils/mem.h"
+#include "./utils/parallel_compile.h"
+#include "./utils/regions.h"
 #include "./utils/return.h"
+#include "./utils/scan.h"
+#include "./utils/script_archive.h"
+#include "./utils/snapshot.h"
+#include "./utils/swizzle.h"
 #include "./utils/types.h"
 #include "./debug/pprint.h"
 
 /* #define SWAP_LOW_HIGH(VALUE) \
 ((u64)(((((u64)(VALUE)) & 0xFFFFFFFFULL) << 32ULL) | ((((u64)(VALUE)) >> 32ULL) & 0xFFFFFFFFULL))) */
 
-#define RDRAM_LENGTH 0x20000000ULL
-_Static_assert((RDRAM_LENGTH >= 4ULL), "");
-
 #define ASSERT(PREDICATE, ...) if (!(PREDICATE)) { \
 	LOG("Assertion failed: %s", (#PREDICATE)); \
 	LOG(__VA_ARGS__); \
 	return; \
 }
 
-static u64 join_low_high(RecompGPR low, RecompGPR high) {
-	return (low & 0xFFFFFFFFULL) | ((high & 0xFFFFFFFFULL) << 32ULL);
-}
-
 static size_t rdram_get_host_index(RecompGPR n64_index) {
 	size_t host_index = (n64_index & 0x7FFFFFFFULL) ^ 3ULL;
 	assert(host_index < RDRAM_LENGTH);
@@ -54,10 +57,7 @@ static int RecompLua_call_game_func(lua_State *L) {
 	LOG("vram = 0x%08llx", vram);
 	LOG("size = %lld", size);
 
-	lua_getglobal(L, "Recomp");
-	lua_pushstring(L, "rdram");
-	lua_rawget(L, -2);
-	u8 *rdram = lua_touserdata(L, -1);
+	u8 *rdram = lua_touserdata(L, lua_upvalueindex(1));
 
 	//void (*func_ptr)(void) = (void *)(rdram + (u64)(vram & 0x7FFFFFFFULL));
 	//LOG("func_ptr = 0x%016"PRIX64, (u64)func_ptr);
@@ -67,21 +67,231 @@ static int RecompLua_call_game_func(lua_State *L) {
 	return 0;
 }
 
+// Built by a single scan of all of memory, normally in `LuaLoader_Init()`.
+// From then on it only ever grows, see `rdram_refresh_caches()`.
+static RDRAMRegionMap rdram_regions = { 0 };
+static bool rdram_regions_are_built = false;
+
+static const RDRAMRegionMap *rdram_get_regions(const u8 *restrict const rdram) {
+	assert(rdram != NULL);
+
+	if (!rdram_regions_are_built) {
+		rdram_region_map_build(&rdram_regions, rdram, RDRAM_LENGTH);
+		rdram_regions_are_built = true;
+	}
+
+	return &rdram_regions;
+}
+
+// Scripts only ever run synchronously on the game thread, so N64 memory cannot
+// change while one of them is executing. The occupied length is thus computed
+// once and then only checked again when the game may have run in between, see
+// `rdram_refresh_caches()`.
+static size_t rdram_occupied_length_cache = 0ULL;
+static bool rdram_occupied_length_cache_is_valid = false;
+
+/**
+ * @brief Check whether `length` is still the occupied length of `rdram`, by
+ *        looking only at the last byte before it and at the
+ *        `RDRAM_HEAP_PROBE_LENGTH` bytes after it.
+ */
+static bool rdram_occupied_length_is_unchanged(const u8 *restrict const rdram, const size_t length, const size_t limit) {
+	if ((length > 0ULL) && (rdram[rdram_get_host_index(length - 1ULL)] == 0)) {
+		return false;
+	}
+
+	// The rest of the word that contains the last occupied byte.
+	const size_t word_end = (length + 3ULL) & ~(size_t)3ULL;
+	for (size_t i = length; (i < word_end) && (i < limit); i++) {
+		if (rdram[rdram_get_host_index(i)] != 0) {
+			return false;
+		}
+	}
+
+	if (word_end >= limit) {
+		return true;
+	}
+
+	const size_t probe_length = ((limit - word_end) < RDRAM_HEAP_PROBE_LENGTH) ? (limit - word_end) : RDRAM_HEAP_PROBE_LENGTH;
+	return rdram_find_occupied_length(rdram + word_end, probe_length) == 0ULL;
+}
+
+/**
+ * @brief Bring the region map and the occupied length up to date after the
+ *        game has run, e.g. at the start of every script invocation or hook.
+ *
+ * Neither is recomputed from scratch: the map is only extended if the heap
+ * grew past its end, and the occupied length is kept as long as the bytes
+ * around it look the same. Both checks only touch a few KiB of memory, so
+ * hooks that run every frame stay cheap.
+ */
+static void rdram_refresh_caches(const u8 *restrict const rdram) {
+	if (!rdram_regions_are_built) {
+		return;
+	}
+
+	if (rdram_region_map_extend(&rdram_regions, rdram, RDRAM_LENGTH)) {
+		LOG("RDRAM heap grew, now ends at 0x%08zX.", rdram_regions.limit);
+	}
+
+	if (
+		rdram_occupied_length_cache_is_valid &&
+		!rdram_occupied_length_is_unchanged(rdram, rdram_occupied_length_cache, rdram_regions.limit)
+	) {
+		rdram_occupied_length_cache_is_valid = false;
+	}
+}
+
 static size_t rdram_get_occupied_length(const u8 *restrict const rdram) {
 	assert(rdram != NULL);
 
-	size_t length = RDRAM_LENGTH;
+	if (!rdram_occupied_length_cache_is_valid) {
+		rdram_occupied_length_cache = rdram_find_occupied_length(rdram, rdram_get_regions(rdram)->limit);
+		rdram_occupied_length_cache_is_valid = true;
+	}
+
+	// Ensure that no overflow has occured above.
+	assert(rdram_occupied_length_cache <= RDRAM_LENGTH);
 
-	size_t index = rdram_get_host_index(length - 1ULL);
-	while ((index >= 0) && (index < RDRAM_LENGTH) && (rdram[index] == 0)) {
-		length--;
-		index = rdram_get_host_index(length - 1ULL);
+	return rdram_occupied_length_cache;
+}
+
+// Shared by `LuaLoader_DumpRDRAMAsync()` and `Recomp.dump_rdram_async()`.
+static DumpWriter rdram_dump_writer = { 0 };
+
+__attribute__((__destructor__))
+static void rdram_stop_dump_writer(void) {
+	dump_writer_stop(&rdram_dump_writer);
+}
+
+static size_t rdram_get_dump_length(const u8 *restrict const rdram, const bool include_tail_nulls);
+
+static const char *const rdram_dump_status_names[] = {
+	[DumpStatus_Unknown + 2] = "unknown",
+	[DumpStatus_Failed  + 2] = "failed",
+	[DumpStatus_Pending + 2] = "pending",
+	[DumpStatus_Done    + 2] = "done",
+};
+
+/**
+ * `Recomp.dump_rdram_async(file_path[, include_tail_nulls])`
+ *
+ * @return A handle for `Recomp.poll_rdram_dump()`, or `nil` and an error
+ *         message if the dump could not be queued.
+ */
+static int RecompLua_dump_rdram_async(lua_State *L) {
+	const u8 *rdram = lua_touserdata(L, lua_upvalueindex(1));
+	assert(rdram != NULL);
+
+	const char *file_path = luaL_checkstring(L, 1);
+	const bool include_tail_nulls = lua_toboolean(L, 2);
+
+	const u32 handle = dump_writer_submit(
+		&rdram_dump_writer,
+		file_path,
+		rdram,
+		rdram_get_dump_length(rdram, include_tail_nulls)
+	);
+
+	if (handle == 0) {
+		lua_pushnil(L);
+		lua_pushstring(L, "all dump buffers are busy");
+		return 2;
 	}
 
-	// Ensure that no underflow has occured above.
-	assert(length <= RDRAM_LENGTH);
+	lua_pushinteger(L, (lua_Integer)handle);
 
-	return length;
+	return 1;
+}
+
+/**
+ * `Recomp.poll_rdram_dump(handle)`
+ *
+ * @return One of `"pending"`, `"done"`, `"failed"` or `"unknown"`.
+ */
+static int RecompLua_poll_rdram_dump(lua_State *L) {
+	const lua_Integer handle = luaL_checkinteger(L, 1);
+	luaL_argcheck(L, (handle >= 0) && (handle <= UINT32_MAX), 1, "invalid handle");
+
+	const DumpStatus status = dump_writer_poll(&rdram_dump_writer, (u32)handle);
+	lua_pushstring(L, rdram_dump_status_names[status + 2]);
+
+	return 1;
+}
+
+/**
+ * `Recomp.preload(names)`: Compile the modules in the sequence `names` on
+ * worker threads (see `utils/parallel_compile.h`) and put their chunks into
+ * `package.preload`. Nothing gets executed yet; the modules still run when
+ * they are first `require()`d, so they keep running in dependency order. Like
+ * any `package.preload` loader, a module gets `":preload:"` as its second
+ * argument instead of its file path.
+ */
+static int RecompLua_preload(lua_State *L) {
+	luaL_checktype(L, 1, LUA_TTABLE);
+	const lua_Integer module_count = luaL_len(L, 1);
+	if (module_count <= 0) {
+		return 0;
+	}
+
+	lua_getglobal(L, LUA_LOADLIBNAME);
+	const int package_index = lua_gettop(L);
+	lua_getfield(L, package_index, "preload");
+	const int preload_index = lua_gettop(L);
+	luaL_checkstack(L, (int)module_count, "too many modules");
+
+	// Keep the resolved paths on the stack, so that the pointers handed to
+	// the workers stay valid.
+	const int paths_index = lua_gettop(L) + 1;
+	for (lua_Integer i = 1; i <= module_count; i++) {
+		lua_geti(L, 1, i);
+		const char *name = luaL_checkstring(L, -1);
+
+		lua_getfield(L, package_index, "searchpath");
+		lua_pushvalue(L, -2);
+		lua_getfield(L, package_index, "path");
+		lua_call(L, 2, 2);
+		if (lua_isnil(L, -2)) {
+			return luaL_error(L, "module '%s' not found:%s", name, lua_tostring(L, -1));
+		}
+
+		lua_pop(L, 1);
+		lua_remove(L, -2);
+	}
+
+	CompileJob *jobs = (CompileJob *)lua_newuserdatauv(L, (size_t)module_count * sizeof(CompileJob), 0);
+	for (lua_Integer i = 0; i < module_count; i++) {
+		jobs[i] = (CompileJob){ .file_path = lua_tostring(L, paths_index + (int)i) };
+	}
+
+	parallel_compile(jobs, (size_t)module_count);
+
+	lua_Integer failed_index = 0;
+	for (lua_Integer i = 0; i < module_count; i++) {
+		if (parallel_compile_load_result(L, &(jobs[i])) != LUA_OK) {
+			failed_index = i + 1;
+			break;
+		}
+
+		lua_geti(L, 1, i + 1);
+		lua_insert(L, -2);
+		lua_settable(L, preload_index);
+	}
+
+	parallel_compile_free_jobs(jobs, (size_t)module_count);
+
+	if (failed_index != 0) {
+		lua_geti(L, 1, failed_index);
+		return luaL_error(
+			L,
+			"error loading module '%s' from file '%s':\n\t%s",
+			lua_tostring(L, -1),
+			lua_tostring(L, paths_index + (int)(failed_index - 1)),
+			lua_tostring(L, -2)
+		);
+	}
+
+	return 0;
 }
 
 static int LuaLoaderRDRAM_get_occupied_length(lua_State *L) {
@@ -111,23 +321,7 @@ static u8 *rdram_get_data(
 		return NULL;
 	}
 
-	// The bitwise XOR operation `z = x ^ y` could cause z to end up larger
-	// than the actually allowed maximum index of `RDRAM_LENGTH - 1`. To avoid
-	// having to check for this edge case in every loop cycle (which would mean
-	// needlessly validating over five million indecies), the loop is split into
-	// two separate parts - one where no out-of-bounds checks are needed and one
-	// where they are used.
-	size_t safe_length = length & ((RDRAM_LENGTH - 1ULL) );
-
-	for (size_t i = 0ULL; i < safe_length; i++) {
-		rdram_converted[i] = ((char *)rdram)[i ^ 3ULL];
-	}
-
-	for (size_t i = safe_length; i < length; i++) {
-		size_t index = i ^ 3ULL;
-		if (index >= length) continue;
-		rdram_converted[i] = ((char *)rdram)[index];
-	}
+	rdram_read_bytes(rdram_converted, rdram, 0ULL, length);
 
 	if (out_length != NULL) *out_length = length;
 	return rdram_converted;
@@ -158,10 +352,7 @@ static int LuaLoaderRDRAM_get_raw_data_as_string(lua_State *L) {
 	u8 *rdram = lua_touserdata(L, 1);
 	assert(rdram != NULL);
 
-	size_t length = RDRAM_LENGTH;
-	while ((length > 1ULL) && (MEM_BU(length, -1) == 0)) length--;
-
-	lua_pushlstring(L, (char *)rdram, length);
+	lua_pushlstring(L, (char *)rdram, rdram_get_occupied_length(rdram));
 
 	return 1;
 }
@@ -182,7 +373,7 @@ static int LuaLoaderRDRAM_get_next_byte_pair(lua_State *L) {
 
 	lua_Integer next_index = index + 1;
 
-	if (next_index > RDRAM_LENGTH) {
+	if (next_index > (lua_Integer)(rdram_get_regions(rdram)->limit)) {
 		return 0;
 	}
 
@@ -196,14 +387,33 @@ static int LuaLoaderRDRAM_len(lua_State *L) {
 	assert(L != NULL);
 
 	//LOG("%s(L=0x%016"PRIX64")", __func__, (u64)L);
-	u8 *_rdram = lua_touserdata(L, 1);
-	assert(_rdram != NULL);
+	u8 *rdram = lua_touserdata(L, 1);
+	assert(rdram != NULL);
 
-	lua_pushinteger(L, RDRAM_LENGTH);
+	// The same end as for `ipairs()`, rather than the full reserved capacity.
+	lua_pushinteger(L, (lua_Integer)(rdram_get_regions(rdram)->limit));
 
 	return 1;
 }
 
+// Like `LuaLoaderRDRAM_get_next_byte_pair()`, but keeps RDRAM, the cursor and
+// the end in its upvalues instead of re-parsing its arguments on every step.
+static int LuaLoaderRDRAM_next_byte_pair_closure(lua_State *L) {
+	const u8 *rdram = lua_touserdata(L, lua_upvalueindex(1));
+	const lua_Integer index = lua_tointeger(L, lua_upvalueindex(2));
+	const lua_Integer limit = lua_tointeger(L, lua_upvalueindex(3));
+
+	if (index >= limit) {
+		return 0;
+	}
+
+	lua_pushinteger(L, index + 1);
+	lua_copy(L, -1, lua_upvalueindex(2));
+	lua_pushinteger(L, rdram[rdram_get_host_index(index)]);
+
+	return 2;
+}
+
 static int LuaLoaderRDRAM_ipairs(lua_State *L) {
 	assert(L != NULL);
 
@@ -211,17 +421,16 @@ static int LuaLoaderRDRAM_ipairs(lua_State *L) {
 	u8 *rdram = lua_touserdata(L, 1);
 	assert(rdram != NULL);
 
-	lua_pushcfunction(L, LuaLoaderRDRAM_get_next_byte_pair);
 	lua_pushlightuserdata(L, rdram);
 	lua_pushinteger(L, 0);
+	lua_pushinteger(L, (lua_Integer)(rdram_get_regions(rdram)->limit));
+	lua_pushcclosure(L, LuaLoaderRDRAM_next_byte_pair_closure, 3);
 
-	return 3;
+	return 1;
 }
 
 static int LuaLoaderRDRAM_pairs(lua_State *L);
 
-static int LuaLoaderRDRAM_index(lua_State *L);
-
 static const luaL_Reg LuaLoaderRDRAM_methods[] = {
 	{ "get_occupied_length",    LuaLoaderRDRAM_get_occupied_length    },
 	{ "get_data_as_string",     LuaLoaderRDRAM_get_data_as_string     },
@@ -238,36 +447,29 @@ static const luaL_Reg LuaLoaderRDRAM_meta_methods[] = {
 	{ "__len",      LuaLoaderRDRAM_len      },
 	{ "__ipairs",   LuaLoaderRDRAM_ipairs   },
 	{ "__pairs",    LuaLoaderRDRAM_pairs    },
-	{ "__index",    LuaLoaderRDRAM_index    },
+	// `__index` needs an upvalue, see `LuaLoader_Init()`.
 	{ NULL,         NULL                    },
 };
 
+// Enumerates `LuaLoaderRDRAM_methods` in declaration order, keeping its
+// position in an upvalue.
 static int LuaLoaderRDRAM_get_next_method_pair(lua_State *L) {
 	assert(L != NULL);
 
-	u8 *_rdram = lua_touserdata(L, 1);
-	assert(_rdram != NULL);
-
-	size_t key_length = 0ULL;
-	const char *key = luaL_optlstring(L, 2, NULL, &key_length);
+	const lua_Integer i = lua_tointeger(L, lua_upvalueindex(1));
 
-	if (key == NULL) {
-		lua_pushstring(L, LuaLoaderRDRAM_methods[0].name);
-		lua_pushcfunction(L, LuaLoaderRDRAM_methods[0].func);
-		return 2;
+	if (LuaLoaderRDRAM_methods[i].name == NULL) {
+		return 0;
 	}
 
-	for (size_t i = 1ULL; LuaLoaderRDRAM_methods[i].name != NULL; i++) {
-		if (strncmp(LuaLoaderRDRAM_methods[i - 1ULL].name, key, key_length) != 0) {
-			continue;
-		}
+	lua_pushinteger(L, i + 1);
+	lua_copy(L, -1, lua_upvalueindex(1));
+	lua_pop(L, 1);
 
-		lua_pushstring(L, LuaLoaderRDRAM_methods[i].name);
-		lua_pushcfunction(L, LuaLoaderRDRAM_methods[i].func);
-		return 2;
-	}
+	lua_pushstring(L, LuaLoaderRDRAM_methods[i].name);
+	lua_pushcfunction(L, LuaLoaderRDRAM_methods[i].func);
 
-	return 0;
+	return 2;
 }
 
 static int LuaLoaderRDRAM_pairs(lua_State *L) {
@@ -276,13 +478,14 @@ static int LuaLoaderRDRAM_pairs(lua_State *L) {
 	u8 *rdram = lua_touserdata(L, 1);
 	assert(rdram != NULL);
 
-	lua_pushcfunction(L, LuaLoaderRDRAM_get_next_method_pair);
-	lua_pushlightuserdata(L, rdram);
-	lua_pushnil(L);
+	lua_pushinteger(L, 0);
+	lua_pushcclosure(L, LuaLoaderRDRAM_get_next_method_pair, 1);
 
-	return 3;
+	return 1;
 }
 
+// The only upvalue of this closure is a table of `LuaLoaderRDRAM_methods`, so
+// looking up a method costs a single `lua_rawget()`.
 static int LuaLoaderRDRAM_index(lua_State *L) {
 	//LOG("%s(L=0x%016"PRIX64")", __func__, (u64)L);
 	u8 *rdram = lua_touserdata(L, 1);
@@ -306,35 +509,151 @@ static int LuaLoaderRDRAM_index(lua_State *L) {
 			return 1;
 		}
 		case LUA_TSTRING: {
-			size_t key_length = 0ULL;
-			const char *key = luaL_checklstring(L, 2, &key_length);
-
-			//LOG("key_length = %zu", key_length);
-			//LOG("key[%zu] = 0x%02"PRIX8, (size_t)(key_length - 1ULL), key[key_length - 1ULL]);
-
-			for (size_t i = 0; LuaLoaderRDRAM_methods[i].name != NULL; i++) {
-				if (strncmp(LuaLoaderRDRAM_methods[i].name, key, key_length) == 0) {
-					lua_pushcfunction(L, LuaLoaderRDRAM_methods[i].func);
-					return 1;
-				}
+			lua_settop(L, 2);
+			if (lua_rawget(L, lua_upvalueindex(1)) == LUA_TNIL) {
+				return luaL_error(L, "Unknown key \"%s\"!", lua_tostring(L, 2));
 			}
 
-			return luaL_error(L, "Unknown key \"%s\"!", key);
+			return 1;
 		}
 	}
 
 	return luaL_typeerror(L, 2, "integer or string");
 }
 
+// The maximum number of Lua states that can exist at the same time.
+#define LUA_STATE_REGISTRY_SIZE 64ULL
+
+// A handle is the index of its slot plus one (so that `0` can mean "no
+// state") in its low bits, and the generation of that slot in the rest.
+#define LUA_STATE_HANDLE_SLOT_BITS 8U
+#define LUA_STATE_HANDLE_SLOT_MASK ((1U << LUA_STATE_HANDLE_SLOT_BITS) - 1U)
+#define LUA_STATE_HANDLE_GENERATION_MASK (0xFFFFFFFFU >> LUA_STATE_HANDLE_SLOT_BITS)
+_Static_assert((LUA_STATE_REGISTRY_SIZE <= LUA_STATE_HANDLE_SLOT_MASK), "");
+
+/**
+ * Lua states live here for as long as the mod keeps them around, so that
+ * script globals survive from one hook (and one frame) to the next. Mod code
+ * only ever sees small integer handles into this registry, and never any host
+ * pointers.
+ */
+static lua_State *lua_state_registry[LUA_STATE_REGISTRY_SIZE] = { 0 };
+
+// Bumped whenever a slot gets freed, so that handles to the state that used to
+// live there stop working instead of silently referring to the next one.
+static u32 lua_state_generations[LUA_STATE_REGISTRY_SIZE] = { 0 };
+
+// The hook dispatcher of each state in `lua_state_registry`, in the same slot.
+static HookDispatcher *hook_dispatchers[LUA_STATE_REGISTRY_SIZE] = { 0 };
+
+/**
+ * @brief Find the slot of the state `handle` refers to.
+ * @return `false` (after logging why) if `handle` does not refer to a live
+ *         state, including if that state has since been closed.
+ */
+static bool lua_state_registry_find(const RecompGPR handle, size_t *restrict const out_index) {
+	const u32 value = (u32)(handle & 0xFFFFFFFFULL);
+	const u64 index = (u64)(value & LUA_STATE_HANDLE_SLOT_MASK) - 1ULL;
+
+	if (
+		(index >= LUA_STATE_REGISTRY_SIZE) ||
+		(lua_state_registry[index] == NULL) ||
+		(lua_state_generations[index] != (value >> LUA_STATE_HANDLE_SLOT_BITS))
+	) {
+		LOG("Invalid or stale Lua state handle %"PRIu32"!", value);
+		return false;
+	}
+
+	*out_index = (size_t)index;
+	return true;
+}
+
+/**
+ * @return The state for `handle`, or `NULL` (after logging why) if `handle`
+ *         does not refer to a live state.
+ */
+static lua_State *lua_state_registry_get(const RecompGPR handle) {
+	size_t index;
+	if (!lua_state_registry_find(handle, &index)) {
+		return NULL;
+	}
+
+	return lua_state_registry[index];
+}
+
+/**
+ * @return The handle of the slot `L` now occupies, or `0` if all are in use.
+ */
+static u32 lua_state_registry_add(lua_State *L, HookDispatcher *hook_dispatcher) {
+	for (size_t i = 0; i < LUA_STATE_REGISTRY_SIZE; i++) {
+		if (lua_state_registry[i] == NULL) {
+			lua_state_registry[i] = L;
+			hook_dispatchers[i] = hook_dispatcher;
+			return (lua_state_generations[i] << LUA_STATE_HANDLE_SLOT_BITS) | (u32)(i + 1);
+		}
+	}
+
+	return 0;
+}
+
+static void lua_state_registry_remove(const size_t index) {
+	lua_state_registry[index] = NULL;
+	hook_dispatchers[index] = NULL;
+	lua_state_generations[index] = (lua_state_generations[index] + 1U) & LUA_STATE_HANDLE_GENERATION_MASK;
+}
+
+/**
+ * Create a new Lua state with the `Recomp` table set up.
+ *
+ * @return A handle to the new state, to be passed to the other `LuaLoader_*()`
+ *         functions until it gets closed by `LuaLoader_Deinit()`, or `0` on
+ *         error.
+ */
 RECOMP_EXPORT void LuaLoader_Init(u8 *rdram, RecompContext *ctx) {
+	return_u32(ctx, 0);
+
 	lua_State *L = luaL_newstate();
 	ASSERT(L != NULL, "Call to `luaL_newstate()` returned NULL!");
 
+	// Only the first state scans all of memory; later ones reuse the map.
+	const RDRAMRegionMap *regions = rdram_get_regions(rdram);
+	for (size_t i = 0; i < regions->count; i++) {
+		LOG(
+			"RDRAM region \"%s\": [0x%08zX, 0x%08zX)",
+			regions->regions[i].name,
+			regions->regions[i].start,
+			regions->regions[i].end
+		);
+	}
+
 	luaL_openlibs(L);
+	bytecode_cache_install_searcher(L);
+
+	HookDispatcher *hook_dispatcher = hook_dispatcher_new(L);
+	const int hook_dispatcher_index = lua_gettop(L);
 
-	lua_createtable(L, 0, 3); {
+	lua_createtable(L, 0, 7); {
 		lua_pushstring(L, "call_game_func");
-		lua_pushcfunction(L, RecompLua_call_game_func);
+		lua_pushlightuserdata(L, rdram);
+		lua_pushcclosure(L, RecompLua_call_game_func, 1);
+		lua_rawset(L, -3);
+
+		lua_pushstring(L, "dump_rdram_async");
+		lua_pushlightuserdata(L, rdram);
+		lua_pushcclosure(L, RecompLua_dump_rdram_async, 1);
+		lua_rawset(L, -3);
+
+		lua_pushstring(L, "poll_rdram_dump");
+		lua_pushcfunction(L, RecompLua_poll_rdram_dump);
+		lua_rawset(L, -3);
+
+		lua_pushstring(L, "preload");
+		lua_pushcfunction(L, RecompLua_preload);
+		lua_rawset(L, -3);
+
+		lua_pushstring(L, "on");
+		lua_pushvalue(L, hook_dispatcher_index);
+		lua_pushcclosure(L, hook_dispatcher_lua_on, 1);
 		lua_rawset(L, -3);
 
 		lua_pushstring(L, "rdram");
@@ -349,6 +668,12 @@ RECOMP_EXPORT void LuaLoader_Init(u8 *rdram, RecompContext *ctx) {
 				lua_pushcfunction(L, LuaLoaderRDRAM_meta_methods[i].func);
 				lua_rawset(L, -3);
 			}
+
+			lua_pushstring(L, "__index");
+			lua_createtable(L, 0, (sizeof(LuaLoaderRDRAM_methods) / sizeof(luaL_Reg)) - 1);
+			luaL_setfuncs(L, LuaLoaderRDRAM_methods, 0);
+			lua_pushcclosure(L, LuaLoaderRDRAM_index, 1);
+			lua_rawset(L, -3);
 		}; lua_setmetatable(L, -2);
 		lua_rawset(L, -3);
 
@@ -366,33 +691,49 @@ RECOMP_EXPORT void LuaLoader_Init(u8 *rdram, RecompContext *ctx) {
 		lua_setmetatable(L, -2);
 		lua_rawset(L, -3); */
 	}; lua_setglobal(L, "Recomp");
+	lua_pop(L, 1);
+
+	const u32 handle = lua_state_registry_add(L, hook_dispatcher);
+	if (handle == 0) {
+		lua_close(L);
+		LOG("Cannot create more than %llu Lua states at once!", LUA_STATE_REGISTRY_SIZE);
+		return;
+	}
 
-	RETURN_INT(ctx, L);
+	return_u32(ctx, handle);
 }
 
 RECOMP_EXPORT void LuaLoader_Deinit(u8 *rdram, RecompContext *ctx) {
-	lua_State *L = (lua_State *)join_low_high(ctx->r5, ctx->r4);
-	ASSERT(L != NULL, "Expected `L` to be a pointer to `lua_State`, but got NULL instead!");
+	size_t index;
+	ASSERT(lua_state_registry_find(ctx->r4, &index), "Expected `handle` to refer to a Lua state!");
 
+	lua_State *L = lua_state_registry[index];
+	lua_state_registry_remove(index);
 	lua_close(L);
 }
 
 typedef struct {
-	struct {
-		u32 high;
-		u32 low;
-	} L;
+	u32 handle;
 	u32 script_code;
 	u32 script_code_size;
 } InvokeScriptCodeArgs;
 
+/**
+ * Run the chunk that was just loaded with status `run_status`, or log the
+ * error message left in its place. Either way, the stack of `L` is left as it
+ * was before loading, since the state outlives this invocation.
+ */
 static void InvokeScriptHelper(lua_State *L, int run_status) {
 	ASSERT(L != NULL, "Expected `L` to be a pointer to `lua_State`, but got NULL instead!");
 
+	// Below the loaded chunk or error message.
+	const int top = lua_gettop(L) - 1;
+
 	if (run_status != LUA_OK) {
 		const char *error_message = lua_tostring(L, -1);
 		if (error_message == NULL) error_message = "<unknown error>";
 		LOG("Lua loading error:\n    %s", error_message);
+		lua_settop(L, top);
 		return;
 	}
 
@@ -400,16 +741,22 @@ static void InvokeScriptHelper(lua_State *L, int run_status) {
 		const char *error_message = lua_tostring(L, -1);
 		if (error_message == NULL) error_message = "<unknown error>";
 		LOG("Lua runtime error:\n    %s", error_message);
+		lua_settop(L, top);
 		return;
 	}
+
+	lua_settop(L, top);
 }
 
 RECOMP_EXPORT void LuaLoader_InvokeScriptCode(u8 *rdram, RecompContext *ctx) {
 	InvokeScriptCodeArgs args =
 		*((InvokeScriptCodeArgs *)(rdram + (ctx->r4 & 0x7FFFFFFFULL)));
 
-	lua_State *L = (lua_State *)join_low_high(args.L.low, args.L.high);
-	ASSERT(L != NULL, "Expected `L` to be a pointer to `lua_State`, but got NULL instead!");
+	lua_State *L = lua_state_registry_get(args.handle);
+	ASSERT(L != NULL, "Expected `args->handle` to refer to a Lua state!");
+
+	// The game may have run since the last script invocation.
+	rdram_refresh_caches(rdram);
 
 	size_t script_code_size = (size_t)args.script_code_size;
 	ASSERT(
@@ -426,35 +773,154 @@ RECOMP_EXPORT void LuaLoader_InvokeScriptCode(u8 *rdram, RecompContext *ctx) {
 }
 
 RECOMP_EXPORT void LuaLoader_InvokeScriptFile(u8 *rdram, RecompContext *ctx) {
-	lua_State *L = (lua_State *)join_low_high(ctx->r5, ctx->r4);
-	ASSERT(L != NULL, "Expected `L` to be a pointer to `lua_State`, but got NULL instead!");
+	lua_State *L = lua_state_registry_get(ctx->r4);
+	ASSERT(L != NULL, "Expected `handle` to refer to a Lua state!");
+
+	// The game may have run since the last script invocation.
+	rdram_refresh_caches(rdram);
 
 	AUTO_FREE char *file_path_str = NULL;
-	ASSERT(get_array(ctx->r6, 0, &file_path_str) > 0, "Failed to get path to script file!");
+	ASSERT(get_array(ctx->r5, 0, &file_path_str) > 0, "Failed to get path to script file!");
 	ASSERT(file_path_str != NULL, "Expected `file_path_str` to be a string, but got NULL instead!");
 
-	return InvokeScriptHelper(L, luaL_loadfilex(L, file_path_str, "t"));
+	return InvokeScriptHelper(L, bytecode_cache_load_file(L, file_path_str));
 }
 
-RECOMP_EXPORT void LuaLoader_DumpRDRAM(const u8 *restrict const rdram, const RecompContext *restrict const ctx) {
-	const RecompGPR file_path_n64 = ctx->r4;
-	const bool include_tail_nulls = ctx->r5 & 1;
+/**
+ * Run every script in the given `;`-separated list of paths, one after another
+ * and in that order. All of them get compiled up front on worker threads, see
+ * `utils/parallel_compile.h`. A script that fails to compile or to run does not
+ * stop the ones after it.
+ */
+RECOMP_EXPORT void LuaLoader_InvokeScriptFiles(u8 *rdram, RecompContext *ctx) {
+	lua_State *L = lua_state_registry_get(ctx->r4);
+	ASSERT(L != NULL, "Expected `handle` to refer to a Lua state!");
+
+	// The game may have run since the last script invocation.
+	rdram_refresh_caches(rdram);
+
+	AUTO_FREE char *file_paths_str = NULL;
+	ASSERT(get_array(ctx->r5, 0, &file_paths_str) > 0, "Failed to get paths to script files!");
+	ASSERT(file_paths_str != NULL, "Expected `file_paths_str` to be a string, but got NULL instead!");
+
+	size_t job_count = 1ULL;
+	for (const char *c = file_paths_str; *c != '\0'; c++) {
+		job_count += (*c == ';') ? 1ULL : 0ULL;
+	}
+
+	AUTO_FREE CompileJob *jobs = (CompileJob *)calloc(job_count, sizeof(CompileJob));
+	ASSERT(jobs != NULL, "Failed to allocate %zu compile jobs!", job_count);
 
-	size_t file_path_length = 0;
-	while (MEM_B(file_path_length, file_path_n64) != 0) {
-		file_path_length++;
+	// Split the list in place; empty entries (e.g. from a trailing `;`) are
+	// skipped.
+	job_count = 0ULL;
+	char *save_ptr = NULL;
+	for (char *file_path = strtok_r(file_paths_str, ";", &save_ptr); file_path != NULL; file_path = strtok_r(NULL, ";", &save_ptr)) {
+		jobs[job_count].file_path = file_path;
+		job_count++;
 	}
 
-	char *file_path = (char *)malloc((file_path_length + 1) * sizeof(char));
-	if (file_path == NULL) {
-		LOG("Failed to allocate memory for file path buffer! (`malloc()` returned NULL)");
-		return;
+	parallel_compile(jobs, job_count);
+
+	for (size_t i = 0; i < job_count; i++) {
+		InvokeScriptHelper(L, parallel_compile_load_result(L, &(jobs[i])));
 	}
 
-	for (size_t i = 0; i < file_path_length; i++) {
-		file_path[i] = (char)MEM_B(i, file_path_n64);
+	parallel_compile_free_jobs(jobs, job_count);
+}
+
+/**
+ * Look up the id of the hook with the given name, for `LuaLoader_Dispatch()`.
+ * Ids stay the same for the lifetime of the state, so this only needs to be
+ * called once per hook. It does not matter whether scripts have registered
+ * callbacks for the hook yet.
+ *
+ * @return The id of the hook, or `0` on error.
+ */
+RECOMP_EXPORT void LuaLoader_GetHookId(u8 *rdram, RecompContext *ctx) {
+	return_u32(ctx, 0);
+
+	lua_State *L = lua_state_registry_get(ctx->r4);
+	ASSERT(L != NULL, "Expected `handle` to refer to a Lua state!");
+
+	AUTO_FREE char *hook_name = NULL;
+	ASSERT(get_array(ctx->r5, 0, &hook_name) > 0, "Failed to get hook name!");
+
+	ASSERT(hook_dispatcher_push(L) != NULL, "Lua state %"PRIu64" has no hook dispatcher!", (u64)(ctx->r4 & 0xFFFFFFFFULL));
+	const u32 hook_id = hook_dispatcher_intern(L, lua_gettop(L), hook_name);
+	lua_pop(L, 1);
+	ASSERT(hook_id != 0, "Cannot register more than %llu different hooks!", HOOK_DISPATCHER_MAX_HOOKS);
+
+	return_u32(ctx, hook_id);
+}
+
+/**
+ * Call every callback that scripts registered with `Recomp.on()` for the hook
+ * with the given id, passing along the two arguments (e.g. the `thisx` and
+ * `play` pointers of an actor update function) as integers.
+ */
+RECOMP_EXPORT void LuaLoader_Dispatch(u8 *rdram, RecompContext *ctx) {
+	size_t index;
+	ASSERT(lua_state_registry_find(ctx->r4, &index), "Expected `handle` to refer to a Lua state!");
+
+	// The game has run since the last script invocation.
+	rdram_refresh_caches(rdram);
+
+	const lua_Integer args[HOOK_DISPATCHER_MAX_ARGS] = {
+		(lua_Integer)(ctx->r6 & 0xFFFFFFFFULL),
+		(lua_Integer)(ctx->r7 & 0xFFFFFFFFULL),
+	};
+
+	hook_dispatcher_dispatch(
+		lua_state_registry[index],
+		hook_dispatchers[index],
+		(u32)(ctx->r5 & 0xFFFFFFFFULL),
+		args,
+		HOOK_DISPATCHER_MAX_ARGS
+	);
+}
+
+/**
+ * Make the modules in the script archive at the given path available to
+ * `require()` in the given Lua state, see `utils/script_archive.h`.
+ *
+ * @return `true` if the archive was mounted.
+ */
+RECOMP_EXPORT void LuaLoader_MountScriptArchive(u8 *rdram, RecompContext *ctx) {
+	return_u32(ctx, false);
+
+	lua_State *L = lua_state_registry_get(ctx->r4);
+	ASSERT(L != NULL, "Expected `handle` to refer to a Lua state!");
+
+	AUTO_FREE char *archive_path = NULL;
+	ASSERT(get_array(ctx->r5, 0, &archive_path) > 0, "Failed to get path to script archive!");
+
+	const char *error_message = script_archive_mount(L, archive_path);
+	ASSERT(error_message == NULL, "Failed to mount script archive \"%s\": %s", archive_path, error_message);
+
+	return_u32(ctx, true);
+}
+
+static size_t rdram_get_dump_length(const u8 *restrict const rdram, const bool include_tail_nulls) {
+	if (include_tail_nulls) {
+		return rdram_get_regions(rdram)->limit;
 	}
 
+	// Dumps are raw host memory, so the last occupied word must be written in
+	// full.
+	return (rdram_get_occupied_length(rdram) + 3ULL) & ~(size_t)3ULL;
+}
+
+RECOMP_EXPORT void LuaLoader_DumpRDRAM(const u8 *restrict const rdram, const RecompContext *restrict const ctx) {
+	const RecompGPR file_path_n64 = ctx->r4;
+	const bool include_tail_nulls = ctx->r5 & 1;
+
+	// The game has run since the last script invocation or dump.
+	rdram_refresh_caches(rdram);
+
+	AUTO_FREE char *file_path = NULL;
+	ASSERT(get_array(file_path_n64, 0, &file_path) > 0, "Failed to get path to dump file!");
+
 	const char mode[] = "wb";
 
 	FILE *const file = fopen(file_path, mode);
@@ -463,12 +929,7 @@ RECOMP_EXPORT void LuaLoader_DumpRDRAM(const u8 *restrict const rdram, const Rec
 		return;
 	}
 
-	size_t num_bytes_to_write = RDRAM_LENGTH;
-	if (!include_tail_nulls) {
-		while ((num_bytes_to_write > 0) && (rdram[num_bytes_to_write - 1] == 0)) {
-			num_bytes_to_write--;
-		}
-	}
+	const size_t num_bytes_to_write = rdram_get_dump_length(rdram, include_tail_nulls);
 
 	LOG("Writing %zu (0x%08zX) bytes to file \"%s\"...", num_bytes_to_write, num_bytes_to_write, file_path);
 	const size_t num_written_bytes = fwrite(rdram, sizeof(u8), num_bytes_to_write, file);
@@ -481,3 +942,188 @@ RECOMP_EXPORT void LuaLoader_DumpRDRAM(const u8 *restrict const rdram, const Rec
 
 	fclose(file);
 }
+
+// The last snapshot written by `LuaLoader_DumpRDRAMSnapshot()`, which the
+// next delta snapshot gets compared against.
+static struct {
+	char *path;
+	u64 *page_hashes;
+	size_t page_count;
+	// The number of snapshots needed to load it, including itself.
+	size_t chain_length;
+} rdram_last_snapshot = { 0 };
+
+static void rdram_forget_last_snapshot(void) {
+	free(rdram_last_snapshot.path);
+	free(rdram_last_snapshot.page_hashes);
+	rdram_last_snapshot.path = NULL;
+	rdram_last_snapshot.page_hashes = NULL;
+	rdram_last_snapshot.page_count = 0;
+	rdram_last_snapshot.chain_length = 0;
+}
+
+/**
+ * Deltas store the path of their base relative to their own directory, so a
+ * whole chain of snapshots can be moved around as long as it stays together.
+ * A base in a different directory is stored with its absolute path instead,
+ * since `rdram.open()` resolves relative ones against the delta's directory.
+ *
+ * @return The path to store, allocated with `malloc()`, or `NULL` on error.
+ */
+static char *rdram_get_relative_base_path(const char *file_path, const char *base_path) {
+	const char *file_separator = strrchr(file_path, '/');
+	const char *base_separator = strrchr(base_path, '/');
+	const size_t file_directory_length = (file_separator != NULL) ? (size_t)(file_separator - file_path + 1) : 0;
+	const size_t base_directory_length = (base_separator != NULL) ? (size_t)(base_separator - base_path + 1) : 0;
+
+	if (
+		(file_directory_length == base_directory_length) &&
+		(strncmp(file_path, base_path, file_directory_length) == 0)
+	) {
+		return strdup(base_path + base_directory_length);
+	}
+
+	if (base_path[0] == '/') {
+		return strdup(base_path);
+	}
+
+	char working_directory[4096];
+	if (getcwd(working_directory, sizeof(working_directory)) == NULL) {
+		return NULL;
+	}
+
+	const size_t size = strlen(working_directory) + 1ULL + strlen(base_path) + 1ULL;
+	char *result = (char *)malloc(size);
+	if (result != NULL) {
+		snprintf(result, size, "%s/%s", working_directory, base_path);
+	}
+
+	return result;
+}
+
+/**
+ * Like `LuaLoader_DumpRDRAM()`, but writes a paged and compressed snapshot
+ * (see `utils/snapshot.h`) instead of a raw byte image. Snapshots can be
+ * opened with `rdram.open()` just like raw dumps.
+ *
+ * With `is_delta`, only the pages that changed since the previous snapshot
+ * get written, along with a reference to it. The first snapshot of a session
+ * is always a full one. Loading a delta means loading every snapshot it builds
+ * on, so a full snapshot is written instead once another delta would make the
+ * chain longer than `rdram.open()` accepts (`SNAPSHOT_MAX_CHAIN_LENGTH`).
+ */
+RECOMP_EXPORT void LuaLoader_DumpRDRAMSnapshot(const u8 *restrict const rdram, const RecompContext *restrict const ctx) {
+	const bool is_delta = ctx->r5 & 1;
+
+	// The game has run since the last script invocation or dump.
+	rdram_refresh_caches(rdram);
+
+	AUTO_FREE char *file_path = NULL;
+	ASSERT(get_array(ctx->r4, 0, &file_path) > 0, "Failed to get path to snapshot file!");
+	ASSERT(file_path != NULL, "Expected `file_path` to be a string, but got NULL instead!");
+
+	const size_t capacity = rdram_get_regions(rdram)->limit;
+	const size_t page_count = (capacity + SNAPSHOT_PAGE_SIZE - 1) / SNAPSHOT_PAGE_SIZE;
+
+	u64 *page_hashes = (u64 *)malloc(page_count * sizeof(u64));
+	if (page_hashes == NULL) {
+		LOG("Failed to allocate memory for page hashes! (`malloc()` returned NULL)");
+		return;
+	}
+
+	const char mode[] = "wb";
+
+	FILE *const file = fopen(file_path, mode);
+	if (file == NULL) {
+		LOG("Failed to open file \"%s\" in \"%s\" mode! (`fopen()` returned NULL)", file_path, mode);
+		free(page_hashes);
+		return;
+	}
+
+	bool has_base = is_delta && (rdram_last_snapshot.path != NULL);
+	if (has_base && (rdram_last_snapshot.chain_length >= SNAPSHOT_MAX_CHAIN_LENGTH)) {
+		LOG(
+			"Delta snapshot chain reached its maximum length of %llu; writing a full snapshot instead.",
+			(unsigned long long)SNAPSHOT_MAX_CHAIN_LENGTH
+		);
+		has_base = false;
+	}
+
+	AUTO_FREE char *base_path = has_base ? rdram_get_relative_base_path(file_path, rdram_last_snapshot.path) : NULL;
+	if (has_base && (base_path == NULL)) {
+		LOG("Failed to get the path of \"%s\" relative to \"%s\"; writing a full snapshot instead.", rdram_last_snapshot.path, file_path);
+		has_base = false;
+	}
+
+	const SnapshotBase base = {
+		.path = base_path,
+		.page_hashes = rdram_last_snapshot.page_hashes,
+		.page_count = rdram_last_snapshot.page_count,
+	};
+
+	if (has_base) {
+		LOG("Writing delta snapshot against \"%s\" to file \"%s\"...", rdram_last_snapshot.path, file_path);
+	} else {
+		LOG("Writing snapshot of %zu (0x%08zX) bytes to file \"%s\"...", capacity, capacity, file_path);
+	}
+
+	const bool success = snapshot_write(file, rdram, capacity, has_base ? &base : NULL, page_hashes);
+	fclose(file);
+
+	const size_t chain_length = has_base ? (rdram_last_snapshot.chain_length + 1ULL) : 1ULL;
+
+	rdram_forget_last_snapshot();
+
+	if (!success) {
+		LOG("Writing failed!");
+		free(page_hashes);
+		return;
+	}
+
+	LOG("Writing completed successfully!")
+
+	rdram_last_snapshot.path = file_path;
+	rdram_last_snapshot.page_hashes = page_hashes;
+	rdram_last_snapshot.page_count = page_count;
+	rdram_last_snapshot.chain_length = chain_length;
+	file_path = NULL;
+}
+
+/**
+ * Like `LuaLoader_DumpRDRAM()`, but only copies the data into a staging
+ * buffer on the calling thread and leaves writing the file to a background
+ * thread, see `utils/dump_writer.h`.
+ *
+ * @return A handle for `LuaLoader_PollRDRAMDump()`, or `0` if the dump could
+ *         not be queued.
+ */
+RECOMP_EXPORT void LuaLoader_DumpRDRAMAsync(const u8 *restrict const rdram, RecompContext *restrict const ctx) {
+	const bool include_tail_nulls = ctx->r5 & 1;
+
+	// The game has run since the last script invocation or dump.
+	rdram_refresh_caches(rdram);
+
+	return_u32(ctx, 0);
+
+	AUTO_FREE char *file_path = NULL;
+	ASSERT(get_array(ctx->r4, 0, &file_path) > 0, "Failed to get path to dump file!");
+	ASSERT(file_path != NULL, "Expected `file_path` to be a string, but got NULL instead!");
+
+	const size_t num_bytes_to_write = rdram_get_dump_length(rdram, include_tail_nulls);
+	const u32 handle = dump_writer_submit(&rdram_dump_writer, file_path, rdram, num_bytes_to_write);
+	if (handle == 0) {
+		LOG("Failed to queue dump to file \"%s\"! (all buffers are busy or out of memory)", file_path);
+	}
+
+	return_u32(ctx, handle);
+}
+
+/**
+ * @return A `DumpStatus`: `1` once the dump has been written, `0` while it is
+ *         still pending, `-1` if writing it failed and `-2` if the handle is
+ *         unknown.
+ */
+RECOMP_EXPORT void LuaLoader_PollRDRAMDump(const u8 *restrict const rdram, RecompContext *restrict const ctx) {
+	const u32 handle = (u32)(ctx->r4 & 0xFFFFFFFFULL);
+	return_s32(ctx, (s32)dump_writer_poll(&rdram_dump_writer, handle));
+}
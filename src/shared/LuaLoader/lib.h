@@ -13,16 +13,27 @@
 #include "modding.h"
 #include "global.h"
 
+// A handle to a Lua state owned by the native library. `0` is never a valid
+// handle.
+typedef u32 LuaLoader_Handle;
+
 typedef struct {
-	u64 L;
+	LuaLoader_Handle handle;
 	const char *script_code;
 	size_t script_code_size;
 } LuaLoader_InvokeScriptCodeArgs;
 
-RECOMP_IMPORT(".", u64 LuaLoader_Init(void));
-RECOMP_IMPORT(".", void LuaLoader_Deinit(u64 L));
+RECOMP_IMPORT(".", LuaLoader_Handle LuaLoader_Init(void));
+RECOMP_IMPORT(".", void LuaLoader_Deinit(LuaLoader_Handle handle));
 RECOMP_IMPORT(".", void LuaLoader_InvokeScriptCode(LuaLoader_InvokeScriptCodeArgs *args));
-RECOMP_IMPORT(".", void LuaLoader_InvokeScriptFile(u64 L, const char *file_path_str));
+RECOMP_IMPORT(".", void LuaLoader_InvokeScriptFile(LuaLoader_Handle handle, const char *file_path_str));
+RECOMP_IMPORT(".", void LuaLoader_InvokeScriptFiles(LuaLoader_Handle handle, const char *file_paths_str));
+RECOMP_IMPORT(".", bool LuaLoader_MountScriptArchive(LuaLoader_Handle handle, const char *archive_path_str));
+RECOMP_IMPORT(".", u32 LuaLoader_GetHookId(LuaLoader_Handle handle, const char *hook_name_str));
+RECOMP_IMPORT(".", void LuaLoader_Dispatch(LuaLoader_Handle handle, u32 hook_id, u32 arg0, u32 arg1));
 RECOMP_IMPORT(".", void LuaLoader_DumpRDRAM(const char *file_path_str, bool include_tail_nulls));
+RECOMP_IMPORT(".", u32 LuaLoader_DumpRDRAMAsync(const char *file_path_str, bool include_tail_nulls));
+RECOMP_IMPORT(".", s32 LuaLoader_PollRDRAMDump(u32 handle));
+RECOMP_IMPORT(".", void LuaLoader_DumpRDRAMSnapshot(const char *file_path_str, bool is_delta));
 
 #endif
@@ -6,12 +6,27 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "../lua/src/lua.h"
 #include "../lua/src/lualib.h"
 #include "../lua/src/lauxlib.h"
 
 #include "../mod_recomp.h"
+#include "../utils/hash.h"
+#include "../utils/lua_pattern.h"
+#include "../utils/lz.h"
 #include "../utils/mem.h"
+#include "../utils/pattern.h"
+#include "../utils/return.h"
+#include "../utils/scan.h"
+#include "../utils/snapshot.h"
+#include "../utils/swizzle.h"
+#include "../utils/value_scan.h"
 #include "../utils/types.h"
 
 #include "rdram.h"
@@ -54,6 +69,7 @@ if (!(PREDICATE)) { \
 ////////////////////////////////////////////////////////////////////////////////
 
 typedef LuaLoader__RDRAM Self;
+typedef LuaLoader__RDRAM__View View;
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -141,37 +157,175 @@ static void display_lua_stack(lua_State *L) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Incremented whenever N64 memory gets written to. Any cached value tagged
+// with an older epoch is stale.
+static u64 rdram_epoch = 1ULL;
+
+static void rdram_invalidate_caches(void) {
+	rdram_epoch++;
+}
+
 __attribute__((__nonnull__))
-__attribute__((__optimize__("-Ofast", "-ffast-math")))
-static lua_Integer rdram_count_length(const Self *restrict const self) {
+static lua_Integer rdram_count_length(Self *restrict const self) {
 	assert(self != NULL);
 
-	const lua_Integer capacity = self->capacity;
-	lua_Integer length = capacity;
-	//fprintf(stderr, "length = %lld, capacity = %lld\n", length, capacity);
+	if (self->cached_length_epoch == rdram_epoch) {
+		return self->cached_length;
+	}
+
+	const lua_Integer length = (lua_Integer)rdram_find_occupied_length(self->raw_data, self->regions.limit);
+
+	// Ensure that no overflow has occured above.
+	assert(length <= self->capacity);
+
+	self->cached_length = length;
+	self->cached_length_epoch = rdram_epoch;
 
-	const u8 *raw_data = self->raw_data;
+	return length;
+}
 
-	/* lua_Integer raw_length = capacity;
-	while ((raw_length > 0) && (raw_data[--raw_length] == 0)) {
-		continue;
+/**
+ * Snapshots (see `utils/snapshot.h`) are not decompressed up front. Instead,
+ * `raw_data` starts out as zero-filled memory and each page is filled in from
+ * the snapshot file the first time it gets accessed.
+ */
+struct LuaLoader__RDRAM__Pager {
+	SnapshotReader *chain; // newest first, each one memory-mapped
+	size_t chain_length;
+	u64 *loaded_pages; // bit set, one bit per page
+};
+
+static void rdram_pager_free(LuaLoader__RDRAM__Pager *pager) {
+	if (pager == NULL) {
+		return;
 	}
 
-	lua_Integer index = raw_length | 3; */
-	lua_Integer index = RDRAM_INDEX(length - 1);
-	while ((index >= 0) && (index < capacity) && (raw_data[index] == 0)) {
-		length--;
-		index = RDRAM_INDEX(length - 1);
+	for (size_t i = 0ULL; i < pager->chain_length; i++) {
+		munmap((void *)(pager->chain[i].file_data), pager->chain[i].file_size);
 	}
 
-	// Ensure that no underflow has occured above.
-	assert(length <= capacity);
+	free(pager->chain);
+	free(pager->loaded_pages);
+	free(pager);
+}
 
-	return length;
+/**
+ * @brief Map the snapshot in `fd` and append it to the end of the chain.
+ *        Takes ownership of `fd`.
+ * @return `NULL` on success, or a description of what went wrong.
+ */
+static const char *rdram_pager_push(LuaLoader__RDRAM__Pager *restrict const pager, const int fd) {
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0) {
+		const int error_code = errno;
+		close(fd);
+		return strerror(error_code);
+	}
+
+	const size_t file_size = (size_t)file_stat.st_size;
+	if (file_size < sizeof(SnapshotHeader)) {
+		close(fd);
+		return "not a snapshot";
+	}
+
+	if (pager->chain_length >= SNAPSHOT_MAX_CHAIN_LENGTH) {
+		close(fd);
+		return "snapshot chain too long";
+	}
+
+	SnapshotReader *chain = realloc(pager->chain, (pager->chain_length + 1ULL) * sizeof(SnapshotReader));
+	if (chain == NULL) {
+		close(fd);
+		return strerror(ENOMEM);
+	}
+
+	pager->chain = chain;
+
+	u8 *file_mapping = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	const int error_code = errno;
+	close(fd);
+
+	if (file_mapping == MAP_FAILED) {
+		return strerror(error_code);
+	}
+
+	const char *error_message = snapshot_reader_init(&(chain[pager->chain_length]), file_mapping, file_size);
+	if (error_message != NULL) {
+		munmap(file_mapping, file_size);
+		return error_message;
+	}
+
+	pager->chain_length++;
+
+	return NULL;
+}
+
+/**
+ * @brief Resolve the base path stored in a delta snapshot, which is relative
+ *        to the directory of the delta itself unless it is absolute.
+ * @return A new string that must be passed to `free()`, or `NULL` if
+ *         allocating it failed.
+ */
+static char *rdram_resolve_base_path(const char *snapshot_path, const char *base_path, const size_t base_path_length) {
+	const char *separator = strrchr(snapshot_path, '/');
+	const int directory_length = ((base_path_length > 0ULL) && (base_path[0] != '/') && (separator != NULL))
+		? (int)(separator - snapshot_path + 1)
+		: 0;
+
+	char *result = NULL;
+	if (asprintf(&result, "%.*s%.*s", directory_length, snapshot_path, (int)base_path_length, base_path) < 0) {
+		return NULL;
+	}
+
+	return result;
+}
+
+static bool rdram_pager_load_page(LuaLoader__RDRAM__Pager *restrict const pager, u8 *restrict const raw_data, const size_t page) {
+	u64 *const bits = &(pager->loaded_pages[page / 64ULL]);
+	const u64 mask = 1ULL << (page % 64ULL);
+
+	if ((*bits & mask) != 0ULL) {
+		return true;
+	}
+
+	const SnapshotReader *reader = snapshot_chain_find_page(pager->chain, pager->chain_length, page);
+	if ((reader == NULL) || !snapshot_reader_read_page(reader, page, raw_data + (page * SNAPSHOT_PAGE_SIZE))) {
+		return false;
+	}
+
+	*bits |= mask;
+
+	return true;
+}
+
+/**
+ * @brief Make sure that the N64 address range `[address, address + length)`
+ *        is backed by actual data. Must be called before accessing
+ *        `self->raw_data` directly; does nothing unless `self` was opened from
+ *        a snapshot.
+ */
+static void rdram_prepare(lua_State *L, const Self *restrict const self, const u64 address, const u64 length) {
+	LuaLoader__RDRAM__Pager *pager = self->pager;
+	if ((pager == NULL) || (length == 0ULL)) {
+		return;
+	}
+
+	const size_t page_count = (size_t)(pager->chain[0].header->page_count);
+	const size_t first_page = (size_t)(address / SNAPSHOT_PAGE_SIZE);
+	size_t last_page = (size_t)((address + length - 1ULL) / SNAPSHOT_PAGE_SIZE);
+	if (last_page >= page_count) {
+		last_page = page_count - 1ULL;
+	}
+
+	for (size_t page = first_page; page <= last_page; page++) {
+		if (!rdram_pager_load_page(pager, self->raw_data, page)) {
+			luaL_error(L, "Snapshot page 0x%I is corrupt!", (lua_Integer)page);
+		}
+	}
 }
 
 static u8 *rdram_get_data(
-		const Self *restrict const self,
+		Self *restrict const self,
 		void *(*alloc_fn)(size_t size),
 		lua_Integer *restrict const out_length
 ) {
@@ -192,29 +346,68 @@ static u8 *rdram_get_data(
 		return NULL;
 	}
 
-	// The bitwise XOR operation `z = x ^ y` could cause z to end up larger
-	// than the actually allowed maximum index of `self->capacity - 1`. To avoid
-	// having to check for this edge case in every loop cycle (which would mean
-	// needlessly validating over five million indecies), the loop is split into
-	// two separate parts - one where no out-of-bounds checks are needed and one
-	// where they are used.
-	lua_Integer safe_length = length & ((self->capacity - 1LL) );
+	rdram_read_bytes(rdram_converted, rdram, 0ULL, (size_t)length);
+
+	if (out_length != NULL) {
+		*out_length = length;
+	}
+
+	return rdram_converted;
+}
 
-	for (lua_Integer i = 0ULL; i < safe_length; i++) {
-		rdram_converted[i] = ((char *)rdram)[i ^ 3LL];
+// How many bytes views de-swizzle at once where they have to. Must be a
+// multiple of eight, see `hash_update()`.
+#define VIEW_CHUNK_LENGTH 0x1000ULL
+
+/**
+ * @brief Like `luaL_testudata()` for `LuaLoader::RDRAM::View`, but also get
+ *        the instance that the view refers to.
+ * @return `NULL` if argument `arg` is not a view.
+ */
+static View *view_test(lua_State *L, const int arg, Self **restrict const out_parent) {
+	View *view = luaL_testudata(L, arg, LuaLoader__RDRAM__View__name);
+	if (view != NULL) {
+		lua_getiuservalue(L, arg, 1);
+		*out_parent = (Self *)lua_touserdata(L, -1);
+		lua_pop(L, 1);
 	}
 
-	for (lua_Integer i = safe_length; i < length; i++) {
-		lua_Integer index = i ^ 3LL;
-		if (index >= length) continue;
-		rdram_converted[i] = ((char *)rdram)[index];
+	return view;
+}
+
+static View *view_check(lua_State *L, const int arg, Self **restrict const out_parent) {
+	View *view = view_test(L, arg, out_parent);
+	if (view == NULL) {
+		luaL_typeerror(L, arg, LuaLoader__RDRAM__View__name);
 	}
 
-	if (out_length != NULL) {
-		*out_length = length;
+	return view;
+}
+
+/**
+ * @brief Copy `length` bytes between two instances, which may or may not share
+ *        their memory. Both ranges must already have been checked and
+ *        prepared.
+ */
+static void rdram_transfer_bytes(
+		Self *const dst,
+		const u64 dst_address,
+		const Self *const src,
+		const u64 src_address,
+		const size_t length
+) {
+	if (dst->raw_data == src->raw_data) {
+		rdram_copy_bytes(dst->raw_data, dst_address, src_address, length);
+		return;
 	}
 
-	return rdram_converted;
+	u8 buffer[VIEW_CHUNK_LENGTH];
+	for (size_t done = 0ULL; done < length;) {
+		const size_t chunk_length = ((length - done) < VIEW_CHUNK_LENGTH) ? (length - done) : VIEW_CHUNK_LENGTH;
+		rdram_read_bytes(buffer, src->raw_data, src_address + done, chunk_length);
+		rdram_write_bytes(dst->raw_data, dst_address + done, buffer, chunk_length);
+		done += chunk_length;
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -227,10 +420,254 @@ int LuaLoader__RDRAM__new(lua_State *L, u8 *rdram, lua_Integer capacity) {
 
 	self->raw_data = rdram;
 	self->capacity = capacity;
+	self->cached_length = 0LL;
+	self->cached_length_epoch = 0ULL;
+	self->is_read_only = false;
+	self->mapping = NULL;
+	self->mapping_size = 0ULL;
+	self->pager = NULL;
+
+	rdram_region_map_build(&(self->regions), rdram, (size_t)capacity);
+
+	return 1;
+}
+
+
+
+/**
+ * @brief The part of `LuaLoader__RDRAM__open()` that deals with snapshots.
+ *        Takes ownership of `fd`.
+ *
+ * Delta snapshots pull in their base (and its base, and so on) right away, so
+ * that a broken chain is reported here rather than on some later access.
+ */
+static int rdram_open_snapshot(
+		lua_State *L,
+		const int fd,
+		const char *file_path,
+		const size_t requested_capacity,
+		const bool is_writable
+) {
+	LuaLoader__RDRAM__Pager *pager = calloc(1ULL, sizeof(LuaLoader__RDRAM__Pager));
+	char *current_path = strdup(file_path);
+	if ((pager == NULL) || (current_path == NULL)) {
+		free(pager);
+		free(current_path);
+		close(fd);
+		errno = ENOMEM;
+		return luaL_fileresult(L, 0, file_path);
+	}
+
+	int error_code = EINVAL;
+	const char *error_message = rdram_pager_push(pager, fd);
+
+	while ((error_message == NULL) && (pager->chain[pager->chain_length - 1ULL].base_path != NULL)) {
+		const SnapshotReader *reader = &(pager->chain[pager->chain_length - 1ULL]);
+		char *base_path = rdram_resolve_base_path(current_path, reader->base_path, reader->base_path_length);
+		if (base_path == NULL) {
+			error_code = ENOMEM;
+			error_message = strerror(error_code);
+			break;
+		}
+
+		free(current_path);
+		current_path = base_path;
+
+		const int base_fd = open(base_path, O_RDONLY);
+		if (base_fd < 0) {
+			error_code = errno;
+			error_message = strerror(error_code);
+			break;
+		}
+
+		error_message = rdram_pager_push(pager, base_fd);
+	}
+
+	if (error_message == NULL) {
+		error_message = snapshot_chain_validate(pager->chain, pager->chain_length);
+	}
+
+	if (error_message != NULL) {
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: %s", current_path, error_message);
+		lua_pushinteger(L, error_code);
+		rdram_pager_free(pager);
+		free(current_path);
+		return 3;
+	}
+
+	free(current_path);
+
+	const SnapshotHeader *header = pager->chain[0].header;
+	const size_t page_count = (size_t)(header->page_count);
+
+	// Pages are always decompressed as a whole, so the memory backing them
+	// has to be rounded up to full pages.
+	size_t capacity = (size_t)(header->capacity);
+	if (requested_capacity > capacity) {
+		capacity = requested_capacity;
+	}
+
+	const size_t mapping_size = (
+		(capacity > (page_count * SNAPSHOT_PAGE_SIZE)) ? capacity : (page_count * SNAPSHOT_PAGE_SIZE)
+	);
+
+	pager->loaded_pages = calloc((page_count + 63ULL) / 64ULL, sizeof(u64));
+	u8 *mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if ((pager->loaded_pages == NULL) || (mapping == MAP_FAILED)) {
+		if (mapping != MAP_FAILED) {
+			munmap(mapping, mapping_size);
+		}
+		rdram_pager_free(pager);
+		errno = ENOMEM;
+		return luaL_fileresult(L, 0, file_path);
+	}
+
+	// Building the region map needs `osMemSize` from the first page and the
+	// last non-zero byte, which lives in the last page that is not all zeros.
+	// Scanning backwards for it never gets past that page, so everything in
+	// between can stay compressed for now.
+	const size_t occupied_page_count = snapshot_chain_occupied_page_count(pager->chain, pager->chain_length);
+	if (
+		!rdram_pager_load_page(pager, mapping, 0ULL) ||
+		((occupied_page_count > 0ULL) && !rdram_pager_load_page(pager, mapping, occupied_page_count - 1ULL))
+	) {
+		munmap(mapping, mapping_size);
+		rdram_pager_free(pager);
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: %s", file_path, "corrupt page data");
+		lua_pushinteger(L, EINVAL);
+		return 3;
+	}
+
+	LuaLoader__RDRAM__new(L, mapping, (lua_Integer)capacity);
+
+	Self *self = luaL_checkudata(L, -1, LuaLoader__RDRAM__name);
+	self->is_read_only = !is_writable;
+	self->mapping = mapping;
+	self->mapping_size = mapping_size;
+	self->pager = pager;
+
+	return 1;
+}
+
+/**
+ * @brief `rdram.open(file_path[, capacity[, is_writable]])`
+ *
+ * Memory-map an RDRAM dump (as written by `LuaLoader_DumpRDRAM()`) instead of
+ * reading all of it up front, so pages only get loaded once they are touched.
+ * If `capacity` is larger than the file, the rest reads as zeros. Writable
+ * dumps are mapped copy-on-write; the file itself is never modified.
+ *
+ * Snapshots (as written by `LuaLoader_DumpRDRAMSnapshot()`) are detected
+ * automatically. Their pages are decompressed on first access; `capacity` can
+ * only make them larger, never smaller. Delta snapshots are reconstructed from
+ * their whole chain of bases.
+ *
+ * @return The new `LuaLoader::RDRAM` instance, or `nil`, an error message and
+ *         an error code if the file could not be mapped, just like `io.open()`.
+ */
+int LuaLoader__RDRAM__open(lua_State *L) {
+	const char *file_path = luaL_checkstring(L, 1);
+	const lua_Integer requested_capacity = luaL_optinteger(L, 2, 0LL);
+	const bool is_writable = lua_toboolean(L, 3);
+
+	luaL_argcheck(
+		L,
+		(requested_capacity >= 0LL) && (requested_capacity <= 0x20000000LL),
+		2,
+		"expected value in range [0, 0x20000000]"
+	);
+
+	const int fd = open(file_path, O_RDONLY);
+	if (fd < 0) {
+		return luaL_fileresult(L, 0, file_path);
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0) {
+		const int error_code = errno;
+		close(fd);
+		errno = error_code;
+		return luaL_fileresult(L, 0, file_path);
+	}
+
+	const size_t file_size = (size_t)file_stat.st_size;
+
+	char magic[sizeof(SNAPSHOT_MAGIC) - 1ULL] = { 0 };
+	if (
+		(file_size >= sizeof(SnapshotHeader)) &&
+		(pread(fd, magic, sizeof(magic), 0) == (ssize_t)sizeof(magic)) &&
+		(memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0)
+	) {
+		return rdram_open_snapshot(L, fd, file_path, (size_t)requested_capacity, is_writable);
+	}
+
+	size_t capacity = (size_t)requested_capacity;
+	if (capacity == 0ULL) {
+		capacity = (file_size + 3ULL) & ~(size_t)3ULL;
+	}
+
+	if (capacity == 0ULL) {
+		close(fd);
+		errno = EINVAL;
+		return luaL_fileresult(L, 0, file_path);
+	}
+
+	const int protection = PROT_READ | (is_writable ? PROT_WRITE : 0);
+
+	// Reserve the whole capacity as zero-filled memory first, then map the
+	// file on top of its beginning. This way, reading past the end of the
+	// file yields zeros instead of `SIGBUS`.
+	u8 *mapping = mmap(NULL, capacity, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) {
+		const int error_code = errno;
+		close(fd);
+		errno = error_code;
+		return luaL_fileresult(L, 0, file_path);
+	}
+
+	const size_t file_mapping_size = (file_size < capacity) ? file_size : capacity;
+	if (
+		(file_mapping_size > 0ULL) &&
+		(mmap(mapping, file_mapping_size, protection, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+	) {
+		const int error_code = errno;
+		munmap(mapping, capacity);
+		close(fd);
+		errno = error_code;
+		return luaL_fileresult(L, 0, file_path);
+	}
+
+	// The mapping stays valid after the file descriptor has been closed.
+	close(fd);
+
+	LuaLoader__RDRAM__new(L, mapping, (lua_Integer)capacity);
+
+	Self *self = luaL_checkudata(L, -1, LuaLoader__RDRAM__name);
+	self->is_read_only = !is_writable;
+	self->mapping = mapping;
+	self->mapping_size = capacity;
 
 	return 1;
 }
 
+int LuaLoader__RDRAM__gc(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+
+	if (self->mapping != NULL) {
+		munmap(self->mapping, self->mapping_size);
+		self->mapping = NULL;
+		self->raw_data = NULL;
+		self->capacity = 0LL;
+	}
+
+	rdram_pager_free(self->pager);
+	self->pager = NULL;
+
+	return 0;
+}
+
 
 
 int LuaLoader__RDRAM__get_length(lua_State *L) {
@@ -247,18 +684,108 @@ int LuaLoader__RDRAM__get_capacity(lua_State *L) {
 
 int LuaLoader__RDRAM__get_data_as_string(lua_State *L) {
 	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	rdram_prepare(L, self, 0ULL, (u64)rdram_count_length(self));
 	lua_Integer length = 0LL;
-	u8 *rdram_converted = rdram_get_data(self, malloc, &length);
+	AUTO_FREE u8 *rdram_converted = rdram_get_data(self, malloc, &length);
+	if (rdram_converted == NULL) {
+		return luaL_error(L, "Failed to allocate memory for a copy of RDRAM!");
+	}
 	lua_pushlstring(L, (char *)rdram_converted, length);
 	return 1;
 }
 
 int LuaLoader__RDRAM__get_raw_data_as_string(lua_State *L) {
 	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
-	lua_pushlstring(L, (char *)(self->raw_data), self->capacity);
+	rdram_prepare(L, self, 0ULL, (u64)(self->regions.limit));
+	lua_pushlstring(L, (char *)(self->raw_data), self->regions.limit);
+	return 1;
+}
+
+int LuaLoader__RDRAM__get_regions(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+
+	lua_createtable(L, (int)(self->regions.count), 0);
+	for (size_t i = 0ULL; i < self->regions.count; i++) {
+		const RDRAMRegion *region = &(self->regions.regions[i]);
+
+		// Both `start` and `stop` are 1-based and inclusive, just like
+		// `string.sub()` and friends.
+		lua_createtable(L, 0, 3); {
+			lua_pushstring(L, region->name);
+			lua_setfield(L, -2, "name");
+
+			lua_pushinteger(L, (lua_Integer)(region->start + 1ULL));
+			lua_setfield(L, -2, "start");
+
+			lua_pushinteger(L, (lua_Integer)(region->end));
+			lua_setfield(L, -2, "stop");
+		}; lua_rawseti(L, -2, (lua_Integer)(i + 1ULL));
+	}
+
 	return 1;
 }
 
+int LuaLoader__RDRAM__refresh_regions(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+
+	rdram_region_map_build(&(self->regions), self->raw_data, (size_t)(self->capacity));
+	self->cached_length_epoch = 0ULL;
+
+	return LuaLoader__RDRAM__get_regions(L);
+}
+
+/**
+ * @brief `rdram:write_snapshot(file_path[, base, base_path])`
+ *
+ * Write all of `rdram` to a snapshot, in the same format as
+ * `LuaLoader_DumpRDRAMSnapshot()`. With `base` (another `LuaLoader::RDRAM`
+ * instance, usually one opened from a snapshot), only the pages that differ
+ * from it are written, and `base_path` is stored as the path to load it from,
+ * relative to the directory of `file_path` unless it is absolute.
+ *
+ * @return `true` on success, or `nil`, an error message and an error code
+ *         (like `io.open()`).
+ */
+int LuaLoader__RDRAM__write_snapshot(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const char *file_path = luaL_checkstring(L, 2);
+	const Self *base = lua_isnoneornil(L, 3) ? NULL : luaL_checkudata(L, 3, LuaLoader__RDRAM__name);
+	const char *base_path = (base != NULL) ? luaL_checkstring(L, 4) : NULL;
+	luaL_argcheck(L, (base_path == NULL) || (base_path[0] != '\0'), 4, "base path must not be empty");
+
+	const size_t capacity = (size_t)(self->capacity);
+	rdram_prepare(L, self, 0ULL, (u64)capacity);
+
+	SnapshotBase snapshot_base = { .path = base_path };
+	if (base != NULL) {
+		const size_t base_capacity = (size_t)(base->capacity);
+		rdram_prepare(L, base, 0ULL, (u64)base_capacity);
+
+		// A userdata rather than `malloc()`, so that it cannot leak if a
+		// later call raises an error.
+		snapshot_base.page_count = (base_capacity + SNAPSHOT_PAGE_SIZE - 1ULL) / SNAPSHOT_PAGE_SIZE;
+		u64 *page_hashes = (u64 *)lua_newuserdatauv(L, (snapshot_base.page_count + 1ULL) * sizeof(u64), 0);
+		for (size_t page = 0ULL; page < snapshot_base.page_count; page++) {
+			page_hashes[page] = hash_bytes(
+				base->raw_data + (page * SNAPSHOT_PAGE_SIZE),
+				snapshot_page_length(base_capacity, page),
+				0ULL
+			);
+		}
+		snapshot_base.page_hashes = page_hashes;
+	}
+
+	FILE *file = fopen(file_path, "wb");
+	if (file == NULL) {
+		return luaL_fileresult(L, 0, file_path);
+	}
+
+	bool success = snapshot_write(file, self->raw_data, capacity, (base != NULL) ? &snapshot_base : NULL, NULL);
+	success = (fclose(file) == 0) && success;
+
+	return luaL_fileresult(L, success, file_path);
+}
+
 
 
 #define CASE(VALUE, BLOCK) case (VALUE): { { BLOCK; }; break; }
@@ -267,9 +794,11 @@ int LuaLoader__RDRAM__get_raw_data_as_string(lua_State *L) {
  * @param[in] L A pointer to the current Lua interpreter stack.
  * @param[in] self A pointer to the instance of `LuaLoader__RDRAM` to read from.
  * @param[in] index A 1-based index into `self->raw_data`. Must be in range
- *                  `1 <= index <= self->capacity`, `0` is a not valid index!
+ *                  `1 <= index <= self->capacity - type_size + 1`, `0` is a
+ *                  not valid index!
  * @param[in] type_size The size in bytes of the type `T` to interpret the data.
  *                      This should simply be `sizeof(T)`.
+ * @return The raw bits of the value, zero-extended to 64 bits.
  */
 static u64 read_value_helper(
 		lua_State *L,
@@ -279,197 +808,1676 @@ static u64 read_value_helper(
 ) {
 	assert(L != NULL);
 	ASSERT(self != NULL);
-	ASSERT(index >= 1);
-	ASSERT(index <= self->capacity);
+	ASSERT(
+		(index >= 1) && (index <= self->capacity - type_size + 1),
+		"Index out of range! (expected value in range [1, %I], got: %I)",
+		(lua_Integer)(self->capacity - type_size + 1),
+		index
+	);
+
+	const u64 address = (u64)(index - 1);
+	rdram_prepare(L, self, address, (u64)type_size);
 
 	switch (type_size) {
 		CASE(0, { return 0; });
-		CASE(1, {
-			TODO;
-		});
-		CASE(2, {
-			TODO;
-		});
-		CASE(4, {
-			TODO;
-		});
-		CASE(8, {
-			/* uint64_t ret = 0;
-			uint64_t lo = (*(int32_t *)(rdram + ((((offset + 4) + (reg))) & 0x7FFFFFFFULL)));
-			uint64_t hi = (*(int32_t *)(rdram + ((((offset + 0) + (reg))) & 0x7FFFFFFFULL)));
-			ret = (lo << 0) | (hi << 32);
-			return ret; */
-
-			// TODO: Test if the `& 0x7FFFFFFFULL` bitmask is redundant here
-			// and, if it is, remove it.
-			u32 low  = *(u32 *)(self->raw_data + ((index + 4) & 0x7FFFFFFFULL));
-			u32 high = *(u32 *)(self->raw_data + ((index + 0) & 0x7FFFFFFFULL));
-
-			return ((u64)low) | (((u64)high) << 32);
-		});
+		CASE(1, { return rdram_load_u8(self->raw_data, address); });
+		CASE(2, { return rdram_load_u16(self->raw_data, address); });
+		CASE(4, { return rdram_load_u32(self->raw_data, address); });
+		CASE(8, { return rdram_load_u64(self->raw_data, address); });
 	}
 
 	return 0;
 }
 
-#define IMPL_READ_VALUE_METHOD(TYPENAME) \
+#define IMPL_READ_VALUE_METHOD(TYPENAME, RAW_TYPENAME, LUA_PUSH_FUNCTION) \
 int LuaLoader__RDRAM__read_value_##TYPENAME(lua_State *L) { \
 	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name); \
-	TODO; \
+	lua_Integer index = luaL_checkinteger(L, 2); \
+	RAW_TYPENAME raw_value = (RAW_TYPENAME)read_value_helper(L, self, index, sizeof(TYPENAME)); \
+	LUA_PUSH_FUNCTION(L, BIT_CAST(RAW_TYPENAME, TYPENAME, raw_value)); \
 	return 1; \
 }
 
-const size_t x = sizeof(u32);
+IMPL_READ_VALUE_METHOD(s8,  u8,  lua_pushinteger)
+IMPL_READ_VALUE_METHOD(s16, u16, lua_pushinteger)
+IMPL_READ_VALUE_METHOD(s32, u32, lua_pushinteger)
+IMPL_READ_VALUE_METHOD(s64, u64, lua_pushinteger)
+IMPL_READ_VALUE_METHOD(u8,  u8,  lua_pushinteger)
+IMPL_READ_VALUE_METHOD(u16, u16, lua_pushinteger)
+IMPL_READ_VALUE_METHOD(u32, u32, lua_pushinteger)
+IMPL_READ_VALUE_METHOD(u64, u64, lua_pushinteger)
+IMPL_READ_VALUE_METHOD(f32, u32, lua_pushnumber)
+IMPL_READ_VALUE_METHOD(f64, u64, lua_pushnumber)
 
-IMPL_READ_VALUE_METHOD(s8)
-IMPL_READ_VALUE_METHOD(s16)
-IMPL_READ_VALUE_METHOD(s32)
-IMPL_READ_VALUE_METHOD(s64)
-IMPL_READ_VALUE_METHOD(u8)
-IMPL_READ_VALUE_METHOD(u16)
-IMPL_READ_VALUE_METHOD(u32)
-IMPL_READ_VALUE_METHOD(u64)
-IMPL_READ_VALUE_METHOD(f32)
-IMPL_READ_VALUE_METHOD(f64)
 
 
+/**
+ * @brief Convert the virtual address at argument `arg` to a 0-based offset into
+ *        RDRAM and ensure that `size` bytes can be read from there.
+ *
+ * KSEG0 (`0x80000000`) and KSEG1 (`0xA0000000`) addresses, sign-extended ones
+ * as found in registers and plain physical addresses are all accepted.
+ */
+static u64 vaddr_check(lua_State *L, const Self *restrict const self, const int arg, const u64 size) {
+	const lua_Integer vaddr = luaL_checkinteger(L, arg);
+	const u64 address = ((u64)vaddr) & 0x1FFFFFFFULL;
+
+	if ((address + size) > (u64)(self->capacity)) {
+		char vaddr_string[sizeof("0xFFFFFFFFFFFFFFFF")];
+		snprintf(vaddr_string, sizeof(vaddr_string), "0x%08"PRIX64, (u64)vaddr);
+		return (u64)luaL_error(
+			L,
+			"Address %s out of range! (RDRAM capacity: %I bytes)",
+			vaddr_string,
+			self->capacity
+		);
+	}
 
-#define IMPL_NEXT_PAIR_METHOD(TYPENAME) \
-int LuaLoader__RDRAM__next_pair_##TYPENAME(lua_State *L) { \
+	rdram_prepare(L, self, address, size);
+
+	return address;
+}
+
+/**
+ * `rdram:u8(vaddr)`, `rdram:s16(vaddr)`, etc.
+ *
+ * Like `read_value_*()`, but addressed the way N64 code and symbol maps do it,
+ * e.g. `rdram:u16(0x801EF670)`, instead of by 1-based index.
+ */
+#define IMPL_VADDR_METHOD(TYPENAME, RAW_TYPENAME, LUA_PUSH_FUNCTION) \
+int LuaLoader__RDRAM__##TYPENAME(lua_State *L) { \
 	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name); \
-	TODO; \
+	const u64 address = vaddr_check(L, self, 2, sizeof(TYPENAME)); \
+	RAW_TYPENAME raw_value = rdram_load_##RAW_TYPENAME(self->raw_data, address); \
+	LUA_PUSH_FUNCTION(L, BIT_CAST(RAW_TYPENAME, TYPENAME, raw_value)); \
 	return 1; \
 }
 
-IMPL_NEXT_PAIR_METHOD(s8)
-IMPL_NEXT_PAIR_METHOD(s16)
-IMPL_NEXT_PAIR_METHOD(s32)
-IMPL_NEXT_PAIR_METHOD(s64)
-IMPL_NEXT_PAIR_METHOD(u8)
-IMPL_NEXT_PAIR_METHOD(u16)
-IMPL_NEXT_PAIR_METHOD(u32)
-IMPL_NEXT_PAIR_METHOD(u64)
-IMPL_NEXT_PAIR_METHOD(f32)
-IMPL_NEXT_PAIR_METHOD(f64)
-
+IMPL_VADDR_METHOD(s8,  u8,  lua_pushinteger)
+IMPL_VADDR_METHOD(s16, u16, lua_pushinteger)
+IMPL_VADDR_METHOD(s32, u32, lua_pushinteger)
+IMPL_VADDR_METHOD(s64, u64, lua_pushinteger)
+IMPL_VADDR_METHOD(u8,  u8,  lua_pushinteger)
+IMPL_VADDR_METHOD(u16, u16, lua_pushinteger)
+IMPL_VADDR_METHOD(u32, u32, lua_pushinteger)
+IMPL_VADDR_METHOD(u64, u64, lua_pushinteger)
+IMPL_VADDR_METHOD(f32, u32, lua_pushnumber)
+IMPL_VADDR_METHOD(f64, u64, lua_pushnumber)
+
+static inline void push_f32s(lua_State *L, const u8 *restrict const raw_data, const u64 address, const u64 count) {
+	for (u64 i = 0ULL; i < count; i++) {
+		lua_pushnumber(L, BIT_CAST(u32, f32, rdram_load_u32(raw_data, address + (i * sizeof(f32)))));
+	}
+}
 
+static inline void push_s16s(lua_State *L, const u8 *restrict const raw_data, const u64 address, const u64 count) {
+	for (u64 i = 0ULL; i < count; i++) {
+		lua_pushinteger(L, BIT_CAST(u16, s16, rdram_load_u16(raw_data, address + (i * sizeof(s16)))));
+	}
+}
 
-int LuaLoader__RDRAM__index(lua_State *L) {
+/**
+ * @brief `rdram:cstring(vaddr[, max_length])`
+ * @return The zero-terminated string at `vaddr`, without the terminator. At
+ *         most `max_length` bytes are read (default: up to the end of RDRAM).
+ */
+int LuaLoader__RDRAM__cstring(lua_State *L) {
 	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
-	switch (lua_type(L, 2)) {
-		CASE(LUA_TNUMBER, {
-			lua_Integer index = luaL_checkinteger(L, 2);
-
-			size_t real_index = RDRAM_INDEX(index - 1);
-			//fprintf(stderr, ">>> real_index = 0x%08zX\n", real_index);
-
-			// The recomp allows N64 code to use up to 512 MiB of RAM. Zero is not a
-			// valid index because Lua uses one-based indexing.
-			ASSERT(
-				(index >= 1) && (index <= self->capacity),
-				"Index out of range! (expected value in range [1, %d], got: %d)",
-				self->capacity,
-				index
-			);
-
-			lua_pushinteger(L, self->raw_data[RDRAM_INDEX(index - 1)]);
-
-			return 1;
-		});
-		CASE(LUA_TSTRING, {
-			/* size_t key_length = 0ULL;
-			const char *key = luaL_checklstring(L, 2, &key_length); */
-
-			ASSERT(lua_getmetatable(L, 1) != 0); // top: table `debug.getmetatable(self)` (metatable of argument #1)
-			lua_pushstring(L, "__methods__"); // top: string "__methods__"
-			ASSERT(lua_rawget(L, -2) == LUA_TTABLE); // top: table `rawget(debug.getmetatable(self), "__methods__")`
-			lua_rotate(L, 2, 2); // top: string `key` (argument #2)
-			lua_rawget(L, -2); // top: function or nil `rawget(debug.getmetatable(self), "__methods__")[key]`
+	const u64 address = vaddr_check(L, self, 2, 0ULL);
+	const lua_Integer available = self->capacity - (lua_Integer)address;
+	lua_Integer max_length = luaL_optinteger(L, 3, available);
+	luaL_argcheck(L, max_length >= 0LL, 3, "length must not be negative");
+	if (max_length > available) {
+		max_length = available;
+	}
 
-			return 1;
-		});
+	// For snapshots, only page in as much as is actually needed.
+	size_t length = 0ULL;
+	while (length < (size_t)max_length) {
+		const size_t chunk_length = ((size_t)max_length - length) < SNAPSHOT_PAGE_SIZE
+			? ((size_t)max_length - length)
+			: SNAPSHOT_PAGE_SIZE;
+		rdram_prepare(L, self, address + length, chunk_length);
+
+		const size_t found = rdram_string_length(self->raw_data, address + length, chunk_length);
+		length += found;
+		if (found < chunk_length) {
+			break;
+		}
 	}
 
-	return luaL_typeerror(L, 2, "integer or string");
-}
+	luaL_Buffer buffer;
+	char *data = luaL_buffinitsize(L, &buffer, length);
+	rdram_read_bytes((u8 *)data, self->raw_data, address, length);
+	luaL_pushresultsize(&buffer, length);
 
-int LuaLoader__RDRAM__newindex(lua_State *L) {
-	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
-	TODO;
 	return 1;
 }
 
-int LuaLoader__RDRAM__tostring(lua_State *L) {
+/**
+ * @brief `rdram:bytes(vaddr, count)`
+ * @return The `count` bytes at `vaddr` as a string, in N64 byte order.
+ */
+int LuaLoader__RDRAM__bytes(lua_State *L) {
 	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const lua_Integer count = luaL_checkinteger(L, 3);
+	luaL_argcheck(L, (count >= 0LL) && (count <= self->capacity), 3, "count out of range");
+	const u64 address = vaddr_check(L, self, 2, (u64)count);
 
-	AUTO_FREE char *str = NULL;
-	int str_length = asprintf(
-		&str,
-		"<userdata %s at 0x%016"PRIX64" { raw_data: 0x%016"PRIX64", capacity: 0x%08"PRIX64" }>",
-		LuaLoader__RDRAM__name,
-		(u64)self,
-		(u64)(self->raw_data),
-		(u64)(self->capacity)
-	);
+	luaL_Buffer buffer;
+	char *data = luaL_buffinitsize(L, &buffer, (size_t)count);
+	rdram_read_bytes((u8 *)data, self->raw_data, address, (size_t)count);
+	luaL_pushresultsize(&buffer, (size_t)count);
 
-	if (str_length < 0) {
-		return luaL_error(L, "Call to `asprintf()` failed! (return code: %d)", str_length);
-	}
+	return 1;
+}
 
-	lua_pushlstring(L, str, str_length);
+/**
+ * The readers below return the fields of common structures as separate
+ * values instead of as a table, so that reading them does not allocate, e.g.
+ * `local x, y, z = rdram:vec3f(actor + 0x24)`.
+ */
 
-	return 1;
+/**
+ * @brief `rdram:vec3f(vaddr)`
+ * @return `x`, `y` and `z` of the `Vec3f` at `vaddr`.
+ */
+int LuaLoader__RDRAM__vec3f(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const u64 address = vaddr_check(L, self, 2, 3ULL * sizeof(f32));
+	push_f32s(L, self->raw_data, address, 3ULL);
+	return 3;
 }
 
-int LuaLoader__RDRAM__len(lua_State *L) {
-	return LuaLoader__RDRAM__get_length(L);
+/**
+ * @brief `rdram:vec3s(vaddr)`
+ * @return `x`, `y` and `z` of the `Vec3s` at `vaddr`.
+ */
+int LuaLoader__RDRAM__vec3s(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const u64 address = vaddr_check(L, self, 2, 3ULL * sizeof(s16));
+	push_s16s(L, self->raw_data, address, 3ULL);
+	return 3;
 }
 
-static int next_method_pair(lua_State *L) {
-	luaL_Reg *methods = lua_touserdata(L, 1);
-	ASSERT(methods != NULL);
-	const char *key = luaL_optstring(L, 2, NULL);
+/**
+ * @brief `rdram:posrot(vaddr)`
+ * @return `pos.x`, `pos.y`, `pos.z`, `rot.x`, `rot.y` and `rot.z` of the
+ *         `PosRot` (a `Vec3f` followed by a `Vec3s`) at `vaddr`.
+ */
+int LuaLoader__RDRAM__posrot(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const u64 address = vaddr_check(L, self, 2, (3ULL * sizeof(f32)) + (3ULL * sizeof(s16)));
+	push_f32s(L, self->raw_data, address, 3ULL);
+	push_s16s(L, self->raw_data, address + (3ULL * sizeof(f32)), 3ULL);
+	return 6;
+}
+
+/**
+ * @brief `rdram:mtxf(vaddr)`
+ * @return All 16 elements of the `MtxF` at `vaddr`, in memory order (i.e.
+ *         `mf[0][0]`, `mf[0][1]`, ..., `mf[3][3]`).
+ */
+int LuaLoader__RDRAM__mtxf(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const u64 address = vaddr_check(L, self, 2, 16ULL * sizeof(f32));
+	luaL_checkstack(L, 16, "too many results");
+	push_f32s(L, self->raw_data, address, 16ULL);
+	return 16;
+}
+
+
+
+/**
+ * @brief Push a sequence of `count` values of type `T` starting at the 1-based
+ *        `index` onto the stack as a single, preallocated array-like table.
+ * @param[in] L A pointer to the current Lua interpreter stack.
+ * @param[in] self A pointer to the instance of `LuaLoader__RDRAM` to read from.
+ * @param[in] type_size The size in bytes of the type `T`.
+ * @param[out] out_address The 0-based N64 address of the first element.
+ * @param[out] out_count The number of elements to read.
+ * @return The number of values pushed onto the stack (always `1`).
+ */
+static int read_array_helper(
+		lua_State *L,
+		const Self *restrict const self,
+		const int_fast8_t type_size,
+		u64 *restrict const out_address,
+		lua_Integer *restrict const out_count
+) {
+	assert(L != NULL);
+	ASSERT(self != NULL);
+
+	const lua_Integer index = luaL_checkinteger(L, 2);
+	const lua_Integer count = luaL_checkinteger(L, 3);
+
+	ASSERT(
+		(count >= 0) && (count <= self->capacity / type_size),
+		"Element count out of range! (expected value in range [0, %I], got: %I)",
+		(lua_Integer)(self->capacity / type_size),
+		count
+	);
+	ASSERT(
+		(index >= 1) && (index <= self->capacity - (count * type_size) + 1),
+		"Index out of range! (expected value in range [1, %I], got: %I)",
+		(lua_Integer)(self->capacity - (count * type_size) + 1),
+		index
+	);
+
+	rdram_prepare(L, self, (u64)(index - 1), (u64)(count * type_size));
+
+	lua_createtable(L, (int)count, 0);
+
+	*out_address = (u64)(index - 1);
+	*out_count = count;
+
+	return 1;
+}
+
+#define IMPL_READ_ARRAY_METHOD(TYPENAME, RAW_TYPENAME, LUA_PUSH_FUNCTION) \
+int LuaLoader__RDRAM__read_array_##TYPENAME(lua_State *L) { \
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name); \
+	u64 address = 0ULL; \
+	lua_Integer count = 0LL; \
+	read_array_helper(L, self, sizeof(TYPENAME), &address, &count); \
+	const u8 *raw_data = self->raw_data; \
+	for (lua_Integer i = 0LL; i < count; i++) { \
+		RAW_TYPENAME raw_value = rdram_load_##RAW_TYPENAME(raw_data, address); \
+		LUA_PUSH_FUNCTION(L, BIT_CAST(RAW_TYPENAME, TYPENAME, raw_value)); \
+		lua_rawseti(L, -2, i + 1LL); \
+		address += sizeof(TYPENAME); \
+	} \
+	return 1; \
+}
+
+IMPL_READ_ARRAY_METHOD(s8,  u8,  lua_pushinteger)
+IMPL_READ_ARRAY_METHOD(s16, u16, lua_pushinteger)
+IMPL_READ_ARRAY_METHOD(s32, u32, lua_pushinteger)
+IMPL_READ_ARRAY_METHOD(s64, u64, lua_pushinteger)
+IMPL_READ_ARRAY_METHOD(u8,  u8,  lua_pushinteger)
+IMPL_READ_ARRAY_METHOD(u16, u16, lua_pushinteger)
+IMPL_READ_ARRAY_METHOD(u32, u32, lua_pushinteger)
+IMPL_READ_ARRAY_METHOD(u64, u64, lua_pushinteger)
+IMPL_READ_ARRAY_METHOD(f32, u32, lua_pushnumber)
+IMPL_READ_ARRAY_METHOD(f64, u64, lua_pushnumber)
+
+
+
+/**
+ * @brief Ensure that `length` bytes starting at the 1-based `index` may be
+ *        written to, and load them first if `self` is a snapshot (so that
+ *        loading the page later on does not overwrite the write).
+ */
+static int write_check_range(
+		lua_State *L,
+		const Self *restrict const self,
+		const lua_Integer index,
+		const lua_Integer length
+) {
+	assert(L != NULL);
+	ASSERT(self != NULL);
+
+	if (self->is_read_only) {
+		return luaL_error(L, "Attempted to write to a read-only RDRAM instance!");
+	}
+
+	ASSERT(
+		(length >= 0) && (length <= self->capacity),
+		"Length out of range! (expected value in range [0, %I], got: %I)",
+		(lua_Integer)(self->capacity),
+		length
+	);
+	ASSERT(
+		(index >= 1) && (index <= self->capacity - length + 1),
+		"Index out of range! (expected value in range [1, %I], got: %I)",
+		(lua_Integer)(self->capacity - length + 1),
+		index
+	);
+
+	rdram_prepare(L, self, (u64)(index - 1), (u64)length);
+
+	// Writes may change the occupied length of any instance sharing this
+	// memory, not just this one.
+	rdram_invalidate_caches();
+
+	return 0;
+}
+
+/**
+ * @brief Write the `type_size` lowest bytes of `raw_value` to the 1-based
+ *        `index`, in the same layout `read_value_helper()` reads them from.
+ */
+static void write_value_helper(
+		lua_State *L,
+		Self *restrict const self,
+		const lua_Integer index,
+		const int_fast8_t type_size,
+		const u64 raw_value
+) {
+	write_check_range(L, self, index, (lua_Integer)type_size);
+
+	const u64 address = (u64)(index - 1);
+
+	switch (type_size) {
+		CASE(1, { rdram_store_u8(self->raw_data, address, (u8)raw_value); });
+		CASE(2, { rdram_store_u16(self->raw_data, address, (u16)raw_value); });
+		CASE(4, { rdram_store_u32(self->raw_data, address, (u32)raw_value); });
+		CASE(8, { rdram_store_u64(self->raw_data, address, raw_value); });
+	}
+}
+
+// Integers that do not fit into `TYPENAME` wrap around, just like they do when
+// N64 code stores them.
+#define IMPL_WRITE_VALUE_METHOD(TYPENAME, RAW_TYPENAME, LUA_CHECK_FUNCTION) \
+int LuaLoader__RDRAM__write_value_##TYPENAME(lua_State *L) { \
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name); \
+	lua_Integer index = luaL_checkinteger(L, 2); \
+	TYPENAME value = (TYPENAME)LUA_CHECK_FUNCTION(L, 3); \
+	write_value_helper(L, self, index, sizeof(TYPENAME), (u64)BIT_CAST(TYPENAME, RAW_TYPENAME, value)); \
+	return 0; \
+}
+
+IMPL_WRITE_VALUE_METHOD(s8,  u8,  luaL_checkinteger)
+IMPL_WRITE_VALUE_METHOD(s16, u16, luaL_checkinteger)
+IMPL_WRITE_VALUE_METHOD(s32, u32, luaL_checkinteger)
+IMPL_WRITE_VALUE_METHOD(s64, u64, luaL_checkinteger)
+IMPL_WRITE_VALUE_METHOD(u8,  u8,  luaL_checkinteger)
+IMPL_WRITE_VALUE_METHOD(u16, u16, luaL_checkinteger)
+IMPL_WRITE_VALUE_METHOD(u32, u32, luaL_checkinteger)
+IMPL_WRITE_VALUE_METHOD(u64, u64, luaL_checkinteger)
+IMPL_WRITE_VALUE_METHOD(f32, u32, luaL_checknumber)
+IMPL_WRITE_VALUE_METHOD(f64, u64, luaL_checknumber)
+
+/**
+ * @brief `rdram:write_bytes(index, data)`
+ *
+ * Copy the string `data` to RDRAM starting at the 1-based `index`, in N64 byte
+ * order (i.e. the inverse of `rdram:get_data_as_string():sub(...)`). `data`
+ * may also be a `LuaLoader::RDRAM::View`, even one of another instance, which
+ * is copied directly.
+ */
+int LuaLoader__RDRAM__write_bytes(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const lua_Integer index = luaL_checkinteger(L, 2);
+
+	Self *source = NULL;
+	const View *view = view_test(L, 3, &source);
+	if (view != NULL) {
+		write_check_range(L, self, index, view->length);
+		rdram_prepare(L, source, view->address, (u64)(view->length));
+		rdram_transfer_bytes(self, (u64)(index - 1), source, view->address, (size_t)(view->length));
+
+		return 0;
+	}
+
+	size_t length = 0ULL;
+	const char *data = luaL_checklstring(L, 3, &length);
+
+	write_check_range(L, self, index, (lua_Integer)length);
+	rdram_write_bytes(self->raw_data, (u64)(index - 1), (const u8 *)data, length);
+
+	return 0;
+}
+
+/**
+ * @brief `rdram:fill(index, count, value)`
+ *
+ * Set `count` bytes starting at the 1-based `index` to `value`, which is
+ * either a byte (`0` to `255`, or `-128` to `-1` for signed bytes) or a string
+ * that gets repeated (and cut off after `count` bytes), in N64 byte order.
+ */
+int LuaLoader__RDRAM__fill(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const lua_Integer index = luaL_checkinteger(L, 2);
+	const lua_Integer count = luaL_checkinteger(L, 3);
+
+	if (lua_type(L, 4) != LUA_TSTRING) {
+		const lua_Integer value = luaL_checkinteger(L, 4);
+		luaL_argcheck(L, (value >= -128LL) && (value <= 255LL), 4, "value out of range for a byte");
+
+		write_check_range(L, self, index, count);
+		rdram_fill_bytes(self->raw_data, (u64)(index - 1), (u8)value, (size_t)count);
+
+		return 0;
+	}
+
+	size_t pattern_length = 0ULL;
+	const char *pattern = lua_tolstring(L, 4, &pattern_length);
+	luaL_argcheck(L, pattern_length > 0ULL, 4, "empty pattern");
+
+	write_check_range(L, self, index, count);
+
+	// Write the pattern once, then keep doubling what has been written so far.
+	const u64 address = (u64)(index - 1);
+	size_t done = (pattern_length < (size_t)count) ? pattern_length : (size_t)count;
+	rdram_write_bytes(self->raw_data, address, (const u8 *)pattern, done);
+	while (done < (size_t)count) {
+		const size_t chunk_length = (done < ((size_t)count - done)) ? done : ((size_t)count - done);
+		rdram_copy_bytes(self->raw_data, address + done, address, chunk_length);
+		done += chunk_length;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief `rdram:copy(dst, src, count)` or `rdram:copy(dst, view)`
+ *
+ * Copy `count` bytes from the 1-based index `src` to the 1-based index `dst`,
+ * like `memmove()` (i.e. both ranges may overlap). Given a view instead, copy
+ * all of it, the same way `rdram:write_bytes()` does.
+ */
+int LuaLoader__RDRAM__copy(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+
+	if (luaL_testudata(L, 3, LuaLoader__RDRAM__View__name) != NULL) {
+		lua_settop(L, 3);
+		return LuaLoader__RDRAM__write_bytes(L);
+	}
+
+	const lua_Integer dst = luaL_checkinteger(L, 2);
+	const lua_Integer src = luaL_checkinteger(L, 3);
+	const lua_Integer count = luaL_checkinteger(L, 4);
+
+	write_check_range(L, self, dst, count);
+	ASSERT(
+		(src >= 1) && (src <= self->capacity - count + 1),
+		"Index out of range! (expected value in range [1, %I], got: %I)",
+		(lua_Integer)(self->capacity - count + 1),
+		src
+	);
+	rdram_prepare(L, self, (u64)(src - 1), (u64)count);
+
+	rdram_copy_bytes(self->raw_data, (u64)(dst - 1), (u64)(src - 1), (size_t)count);
+
+	return 0;
+}
+
+
+
+/**
+ * @brief Convert argument `arg` to the raw bits of a value of type `type`.
+ *        Integers that do not fit into `type` wrap around.
+ */
+static u64 scan_check_value(lua_State *L, const int arg, const ScanType type) {
+	switch (type) {
+		CASE(ScanType_f32, { return (u64)BIT_CAST(f32, u32, (f32)luaL_checknumber(L, arg)); });
+		CASE(ScanType_f64, { return BIT_CAST(f64, u64, (f64)luaL_checknumber(L, arg)); });
+		default: {
+			return (u64)luaL_checkinteger(L, arg);
+		}
+	}
+}
+
+static void scan_push_value(lua_State *L, const ScanType type, const u64 value_bits) {
+	switch (type) {
+		CASE(ScanType_s8,  { lua_pushinteger(L, (lua_Integer)BIT_CAST(u8,  s8,  (u8)value_bits)); });
+		CASE(ScanType_s16, { lua_pushinteger(L, (lua_Integer)BIT_CAST(u16, s16, (u16)value_bits)); });
+		CASE(ScanType_s32, { lua_pushinteger(L, (lua_Integer)BIT_CAST(u32, s32, (u32)value_bits)); });
+		CASE(ScanType_s64, { lua_pushinteger(L, (lua_Integer)BIT_CAST(u64, s64, value_bits)); });
+		CASE(ScanType_u8,  { lua_pushinteger(L, (lua_Integer)(u8)value_bits); });
+		CASE(ScanType_u16, { lua_pushinteger(L, (lua_Integer)(u16)value_bits); });
+		CASE(ScanType_u32, { lua_pushinteger(L, (lua_Integer)(u32)value_bits); });
+		CASE(ScanType_u64, { lua_pushinteger(L, (lua_Integer)value_bits); });
+		CASE(ScanType_f32, { lua_pushnumber(L, (lua_Number)BIT_CAST(u32, f32, (u32)value_bits)); });
+		CASE(ScanType_f64, { lua_pushnumber(L, (lua_Number)BIT_CAST(u64, f64, value_bits)); });
+		default: {
+			lua_pushnil(L);
+		}
+	}
+}
+
+/**
+ * @brief `rdram:scan(type, predicate[, value[, start[, stop]]])` or
+ *        `rdram:scan(type, predicate, value, view)`
+ *
+ * Collect every index in `[start, stop]` (1-based and inclusive, defaulting to
+ * all regions in use) or in `view` whose value of type `type` satisfies
+ * `predicate` into a new `LuaLoader::RDRAM::ScanResult`. Only indices aligned
+ * to the size of `type` are considered. Use `"any"` to start from everything
+ * and narrow it down later with `ScanResult:refine()`.
+ *
+ * @param type One of `"s8"`, `"s16"`, `"s32"`, `"s64"`, `"u8"`, `"u16"`,
+ *             `"u32"`, `"u64"`, `"f32"` or `"f64"`.
+ * @param predicate One of `"=="`, `"~="`, `"<"`, `"<="`, `">"`, `">="` (which
+ *                  compare against `value`) or `"any"`.
+ */
+int LuaLoader__RDRAM__scan(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const ScanType type = (ScanType)luaL_checkoption(L, 2, NULL, scan_type_names);
+	const ScanPredicate predicate = (ScanPredicate)luaL_checkoption(L, 3, NULL, scan_predicate_names);
+
+	luaL_argcheck(L, !scan_predicate_needs_previous(predicate), 3, "a first scan has nothing to compare against");
+	const u64 value_bits = scan_predicate_needs_value(predicate) ? scan_check_value(L, 4, type) : 0ULL;
+
+	lua_Integer start = 0LL;
+	lua_Integer stop = 0LL;
+	Self *source = NULL;
+	const View *range = view_test(L, 5, &source);
+	if (range != NULL) {
+		luaL_argcheck(L, source->raw_data == self->raw_data, 5, "view of a different RDRAM instance");
+		start = (lua_Integer)(range->address) + 1LL;
+		stop = start + range->length - 1LL;
+	} else {
+		start = luaL_optinteger(L, 5, 1LL);
+		stop = luaL_optinteger(L, 6, (lua_Integer)(self->regions.limit));
+	}
+	luaL_argcheck(L, (start >= 1LL) && (start <= self->capacity + 1LL), 5, "index out of range");
+	luaL_argcheck(L, (stop >= start - 1LL) && (stop <= self->capacity), 6, "index out of range");
+
+	rdram_prepare(L, self, (u64)(start - 1LL), (u64)(stop - start + 1LL));
+
+	LuaLoader__RDRAM__ScanResult *result = lua_newuserdatauv(L, sizeof(LuaLoader__RDRAM__ScanResult), 1);
+	*result = (LuaLoader__RDRAM__ScanResult){ .set = { .type = type } };
+	luaL_setmetatable(L, LuaLoader__RDRAM__ScanResult__name);
+
+	// Keep the `LuaLoader::RDRAM` instance alive for as long as its results.
+	lua_pushvalue(L, 1);
+	lua_setiuservalue(L, -2, 1);
+
+	if (!scan_first(&(result->set), self->raw_data, (u64)(start - 1LL), (u64)stop, predicate, value_bits)) {
+		return luaL_error(L, "Failed to allocate memory for scan results!");
+	}
+
+	return 1;
+}
+
+/**
+ * @brief `result:refine(predicate[, value])`
+ *
+ * Keep only the indices whose current value satisfies `predicate`, which may
+ * also be one of `"changed"`, `"unchanged"`, `"increased"` or `"decreased"`
+ * to compare against the value seen by the previous scan.
+ *
+ * @return `result` itself, so calls can be chained.
+ */
+int LuaLoader__RDRAM__ScanResult__refine(lua_State *L) {
+	LuaLoader__RDRAM__ScanResult *result = luaL_checkudata(L, 1, LuaLoader__RDRAM__ScanResult__name);
+	const ScanPredicate predicate = (ScanPredicate)luaL_checkoption(L, 2, NULL, scan_predicate_names);
+	const u64 value_bits = scan_predicate_needs_value(predicate) ? scan_check_value(L, 3, result->set.type) : 0ULL;
+
+	lua_getiuservalue(L, 1, 1);
+	Self *self = luaL_checkudata(L, -1, LuaLoader__RDRAM__name);
+	lua_pop(L, 1);
+
+	if (self->raw_data == NULL) {
+		return luaL_error(L, "The RDRAM instance of this scan result has already been closed!");
+	}
+
+	const ScanResultSet *set = &(result->set);
+	if (set->count > 0ULL) {
+		const u64 first = set->addresses[0];
+		const u64 last = set->addresses[set->count - 1ULL];
+		rdram_prepare(L, self, first, last - first + scan_type_sizes[set->type]);
+	}
+
+	scan_refine(&(result->set), self->raw_data, predicate, value_bits);
+
+	lua_settop(L, 1);
+
+	return 1;
+}
+
+int LuaLoader__RDRAM__ScanResult__count(lua_State *L) {
+	LuaLoader__RDRAM__ScanResult *result = luaL_checkudata(L, 1, LuaLoader__RDRAM__ScanResult__name);
+	lua_pushinteger(L, (lua_Integer)(result->set.count));
+	return 1;
+}
+
+/**
+ * @brief `result:get(i)`
+ * @return The `i`-th matching index (1-based, like everything else) and its
+ *         value as of the last scan, or nothing if `i` is out of range.
+ */
+int LuaLoader__RDRAM__ScanResult__get(lua_State *L) {
+	LuaLoader__RDRAM__ScanResult *result = luaL_checkudata(L, 1, LuaLoader__RDRAM__ScanResult__name);
+	const lua_Integer i = luaL_checkinteger(L, 2);
+
+	if ((i < 1LL) || (i > (lua_Integer)(result->set.count))) {
+		return 0;
+	}
+
+	lua_pushinteger(L, (lua_Integer)(result->set.addresses[i - 1LL]) + 1LL);
+	scan_push_value(L, result->set.type, scan_result_set_get_value(&(result->set), (size_t)(i - 1LL)));
+
+	return 2;
+}
+
+/**
+ * @brief `result:to_table([max_count])`
+ * @return An array of the first `max_count` (default: all) matching indices.
+ */
+int LuaLoader__RDRAM__ScanResult__to_table(lua_State *L) {
+	LuaLoader__RDRAM__ScanResult *result = luaL_checkudata(L, 1, LuaLoader__RDRAM__ScanResult__name);
+	lua_Integer count = luaL_optinteger(L, 2, (lua_Integer)(result->set.count));
+	if ((count < 0LL) || (count > (lua_Integer)(result->set.count))) {
+		count = (lua_Integer)(result->set.count);
+	}
+
+	lua_createtable(L, (int)count, 0);
+	for (lua_Integer i = 0LL; i < count; i++) {
+		lua_pushinteger(L, (lua_Integer)(result->set.addresses[i]) + 1LL);
+		lua_rawseti(L, -2, i + 1LL);
+	}
+
+	return 1;
+}
+
+int LuaLoader__RDRAM__ScanResult__tostring(lua_State *L) {
+	LuaLoader__RDRAM__ScanResult *result = luaL_checkudata(L, 1, LuaLoader__RDRAM__ScanResult__name);
+	lua_pushfstring(
+		L,
+		"<userdata %s at %p { type: %s, count: %I }>",
+		LuaLoader__RDRAM__ScanResult__name,
+		(void *)result,
+		scan_type_names[result->set.type],
+		(lua_Integer)(result->set.count)
+	);
+	return 1;
+}
+
+int LuaLoader__RDRAM__ScanResult__gc(lua_State *L) {
+	LuaLoader__RDRAM__ScanResult *result = luaL_checkudata(L, 1, LuaLoader__RDRAM__ScanResult__name);
+	scan_result_set_free(&(result->set));
+	return 0;
+}
+
+
+
+// How many bytes `rdram:find_pattern()` de-swizzles at once.
+#define FIND_PATTERN_WINDOW_SIZE 0x10000ULL
+
+typedef struct FindPatternState {
+	BytePattern pattern;
+	u64 position; // the next address a match may start at
+	u64 stop;     // exclusive
+	u64 window_start;
+	size_t window_length;
+	u8 window[FIND_PATTERN_WINDOW_SIZE + BYTE_PATTERN_MAX_LENGTH - 1ULL];
+} FindPatternState;
+
+static int find_pattern_next(lua_State *L) {
+	Self *self = lua_touserdata(L, lua_upvalueindex(1));
+	FindPatternState *state = lua_touserdata(L, lua_upvalueindex(2));
+
+	if (self->raw_data == NULL) {
+		return luaL_error(L, "Attempted to search a closed RDRAM instance!");
+	}
+
+	const size_t length = state->pattern.length;
+
+	while ((state->position + length) <= state->stop) {
+		const u64 window_stop = state->window_start + state->window_length;
+
+		// Matches must not be cut off at the end of the window (unless the
+		// window already reaches `stop`, in which case they cannot exist).
+		if (
+			(state->position < state->window_start) ||
+			((state->position + length) > window_stop) ||
+			(state->window_length == 0ULL)
+		) {
+			const u64 remaining = state->stop - state->position;
+			state->window_start = state->position;
+			state->window_length = (size_t)(remaining < sizeof(state->window) ? remaining : sizeof(state->window));
+
+			rdram_prepare(L, self, state->window_start, state->window_length);
+			rdram_read_bytes(state->window, self->raw_data, state->window_start, state->window_length);
+		}
+
+		const size_t offset = (size_t)(state->position - state->window_start);
+		const size_t hit = byte_pattern_find(&(state->pattern), state->window + offset, state->window_length - offset);
+
+		if (hit != SIZE_MAX) {
+			const u64 address = state->position + hit;
+			state->position = address + 1ULL;
+			lua_pushinteger(L, (lua_Integer)address + 1LL);
+			return 1;
+		}
+
+		if ((state->window_start + state->window_length) >= state->stop) {
+			break;
+		}
+
+		// Continue with the first start position that did not fit.
+		state->position = state->window_start + state->window_length - length + 1ULL;
+	}
+
+	state->position = state->stop;
+
+	return 0;
+}
+
+/**
+ * @brief `rdram:find_pattern(pattern[, start[, stop]])`
+ *
+ * Search `[start, stop]` (1-based and inclusive, defaulting to all regions in
+ * use) for a byte signature in N64 byte order, like `"3C 08 ?? ?? 25 08"`,
+ * where `??` matches any byte. Overlapping matches are all reported.
+ *
+ * @return An iterator over the index of every match, for use in generic `for`
+ *         loops. Memory is read lazily, so matches reflect the state of RDRAM
+ *         at the time the iterator reaches them.
+ */
+int LuaLoader__RDRAM__find_pattern(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	size_t pattern_length = 0ULL;
+	const char *pattern = luaL_checklstring(L, 2, &pattern_length);
+
+	const lua_Integer start = luaL_optinteger(L, 3, 1LL);
+	const lua_Integer stop = luaL_optinteger(L, 4, (lua_Integer)(self->regions.limit));
+	luaL_argcheck(L, (start >= 1LL) && (start <= self->capacity + 1LL), 3, "index out of range");
+	luaL_argcheck(L, (stop >= start - 1LL) && (stop <= self->capacity), 4, "index out of range");
+
+	lua_settop(L, 1);
+
+	FindPatternState *state = lua_newuserdatauv(L, sizeof(FindPatternState), 0);
+	state->position = (u64)(start - 1LL);
+	state->stop = (u64)stop;
+	state->window_start = 0ULL;
+	state->window_length = 0ULL;
+
+	const char *error = byte_pattern_parse(&(state->pattern), pattern, pattern_length);
+	luaL_argcheck(L, error == NULL, 2, error);
+
+	lua_pushcclosure(L, find_pattern_next, 2);
+
+	return 1;
+}
+
+
+
+// The initial size of the window `rdram:match()` and `rdram:gmatch()` run the
+// matcher over; it grows whenever a match does not fit into it.
+#define MATCH_WINDOW_SIZE 0x10000ULL
+
+typedef struct MatchState {
+	LuaPatternMatchState ms;
+	const char *pattern; // kept alive by the caller
+	bool is_anchored;
+	u64 start;        // the subject is `[start, stop)`
+	u64 stop;
+	u64 position;     // the next address a match may start at
+	u64 last_match;   // the end of the previous match, or `UINT64_MAX`
+	u64 window_start;
+	size_t window_length;
+	size_t window_capacity;
+	char *window;     // owned by user value 1 of the `MatchState` userdata
+} MatchState;
+
+/**
+ * @brief De-swizzle `[address, address + capacity)` (clamped to the subject)
+ *        into the window of `state`, which lives at `state_index`.
+ *
+ * The window is preceded by the byte before `address`, or by `'\0'` at the
+ * start of the subject, and followed by a `'\0'`, see `utils/lua_pattern.h`.
+ */
+static void match_load_window(
+		lua_State *L,
+		const Self *restrict const self,
+		MatchState *restrict const state,
+		const int state_index,
+		const u64 address,
+		const size_t capacity
+) {
+	if ((state->window == NULL) || (state->window_capacity < capacity)) {
+		state->window = lua_newuserdatauv(L, capacity + 2ULL, 0);
+		state->window_capacity = capacity;
+		lua_setiuservalue(L, state_index, 1);
+	}
+
+	const u64 remaining = state->stop - address;
+	state->window_start = address;
+	state->window_length = (size_t)(remaining < state->window_capacity ? remaining : state->window_capacity);
+
+	if (address > state->start) {
+		rdram_prepare(L, self, address - 1ULL, state->window_length + 1ULL);
+		state->window[0] = (char)rdram_load_u8(self->raw_data, address - 1ULL);
+	} else {
+		rdram_prepare(L, self, address, state->window_length);
+		state->window[0] = '\0';
+	}
+
+	rdram_read_bytes((u8 *)(state->window + 1), self->raw_data, address, state->window_length);
+	state->window[state->window_length + 1ULL] = '\0';
+}
+
+/**
+ * @brief Find the next match at or after `state->position`, reloading and
+ *        growing the window as needed.
+ * @return The end of the match within the window (with `*match_start` set to
+ *         its start), or `NULL` if there are no more matches.
+ */
+static const char *match_find_next(
+		lua_State *L,
+		const Self *restrict const self,
+		MatchState *restrict const state,
+		const int state_index,
+		const char **restrict const match_start
+) {
+	LuaPatternMatchState *ms = &(state->ms);
+	const bool starts_with_literal = lua_pattern_starts_with_literal(state->pattern, ms->p_end);
+
+	while (state->position <= state->stop) {
+		const u64 window_stop = state->window_start + state->window_length;
+		if (
+			(state->window == NULL) ||
+			(state->position < state->window_start) ||
+			(state->position > window_stop) ||
+			((state->position == window_stop) && (window_stop < state->stop))
+		) {
+			match_load_window(L, self, state, state_index, state->position, MATCH_WINDOW_SIZE);
+		}
+
+		ms->L = L;
+		ms->src_init = state->window + 1;
+		ms->src_end = ms->src_init + state->window_length;
+		ms->position_offset = (lua_Integer)(state->window_start);
+
+		const bool is_window_final = (state->window_start + state->window_length) >= state->stop;
+		const char *s = ms->src_init + (state->position - state->window_start);
+
+		if (starts_with_literal && (s < ms->src_end)) {
+			const char *hit = memchr(s, *(state->pattern), (size_t)(ms->src_end - s));
+			s = (hit != NULL) ? hit : ms->src_end;
+			if (state->is_anchored && (s != ms->src_init + (state->position - state->window_start))) {
+				break;
+			}
+			state->position = state->window_start + (u64)(s - ms->src_init);
+			if ((hit == NULL) && !is_window_final) {
+				continue;
+			}
+		}
+
+		ms->level = 0;
+		ms->hit_end = false;
+		const char *e = lua_pattern_match(ms, s, state->pattern);
+
+		if (ms->hit_end && !is_window_final) {
+			// The outcome might change once more of the subject is visible.
+			const size_t capacity = (state->position == state->window_start)
+				? (state->window_capacity * 2ULL)
+				: state->window_capacity;
+			match_load_window(L, self, state, state_index, state->position, capacity);
+			continue;
+		}
+
+		if ((e != NULL) && ((state->window_start + (u64)(e - ms->src_init)) != state->last_match)) {
+			*match_start = s;
+			return e;
+		}
+
+		if (state->is_anchored) {
+			break;
+		}
+
+		state->position++;
+	}
+
+	state->position = state->stop + 1ULL;
+
+	return NULL;
+}
+
+/**
+ * @brief Parse the arguments shared by `rdram:match()` and `rdram:gmatch()`
+ *        and push a new `MatchState` userdata. Like `string.gmatch()`, the
+ *        latter treats a leading `^` as a literal character.
+ */
+static MatchState *match_push_state(lua_State *L, Self *restrict const self, const bool allow_anchor) {
+	size_t pattern_length = 0ULL;
+	const char *pattern = luaL_checklstring(L, 2, &pattern_length);
+
+	const lua_Integer start = luaL_optinteger(L, 3, 1LL);
+	const lua_Integer stop = luaL_optinteger(L, 4, (lua_Integer)(self->regions.limit));
+	luaL_argcheck(L, (start >= 1LL) && (start <= self->capacity + 1LL), 3, "index out of range");
+	luaL_argcheck(L, (stop >= start - 1LL) && (stop <= self->capacity), 4, "index out of range");
+
+	MatchState *state = lua_newuserdatauv(L, sizeof(MatchState), 1);
+	*state = (MatchState){
+		.pattern = pattern,
+		.is_anchored = allow_anchor && (pattern_length > 0ULL) && (*pattern == '^'),
+		.start = (u64)(start - 1LL),
+		.stop = (u64)stop,
+		.position = (u64)(start - 1LL),
+		.last_match = UINT64_MAX,
+	};
+
+	if (state->is_anchored) {
+		state->pattern++;
+	}
+
+	state->ms.matchdepth = LUA_PATTERN_MAX_CALLS;
+	state->ms.p_end = pattern + pattern_length;
+
+	return state;
+}
+
+/**
+ * @brief `rdram:match(pattern[, start[, stop]])`
+ *
+ * Like `string.match(rdram:get_data_as_string():sub(start, stop), pattern)`,
+ * but without ever creating that string. `start` and `stop` are 1-based and
+ * inclusive, defaulting to all regions in use. Position captures (`()`) are
+ * returned as indices into RDRAM, so they can be passed to the other methods.
+ */
+int LuaLoader__RDRAM__match(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	MatchState *state = match_push_state(L, self, true);
+	const int state_index = lua_gettop(L);
+
+	const char *match_start = NULL;
+	const char *match_end = match_find_next(L, self, state, state_index, &match_start);
+	if (match_end == NULL) {
+		luaL_pushfail(L);
+		return 1;
+	}
+
+	return lua_pattern_push_captures(&(state->ms), match_start, match_end);
+}
+
+static int gmatch_next(lua_State *L) {
+	Self *self = lua_touserdata(L, lua_upvalueindex(1));
+	MatchState *state = lua_touserdata(L, lua_upvalueindex(3));
+
+	if (self->raw_data == NULL) {
+		return luaL_error(L, "Attempted to search a closed RDRAM instance!");
+	}
+
+	const char *match_start = NULL;
+	const char *match_end = match_find_next(L, self, state, lua_upvalueindex(3), &match_start);
+	if (match_end == NULL) {
+		return 0;
+	}
+
+	state->position = state->window_start + (u64)(match_end - state->ms.src_init);
+	state->last_match = state->position;
+
+	return lua_pattern_push_captures(&(state->ms), match_start, match_end);
+}
+
+/**
+ * @brief `rdram:gmatch(pattern[, start[, stop]])`
+ *
+ * Like `string.gmatch()`, see `rdram:match()`. Memory is read lazily, so each
+ * match reflects the state of RDRAM at the time the iterator reaches it.
+ */
+int LuaLoader__RDRAM__gmatch(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	lua_settop(L, 4);
+	match_push_state(L, self, false);
+
+	// Keep the instance and the pattern alive for as long as the iterator.
+	lua_pushvalue(L, 1);
+	lua_pushvalue(L, 2);
+	lua_rotate(L, -3, 2);
+	lua_pushcclosure(L, gmatch_next, 3);
+
+	return 1;
+}
+
+
+
+static inline u64 iter_load_bits(const u8 *restrict const raw_data, const u64 address, const ScanType type) {
+	switch (scan_type_sizes[type]) {
+		CASE(1, { return rdram_load_u8(raw_data, address); });
+		CASE(2, { return rdram_load_u16(raw_data, address); });
+		CASE(4, { return rdram_load_u32(raw_data, address); });
+		CASE(8, { return rdram_load_u64(raw_data, address); });
+	}
+
+	return 0ULL;
+}
+
+/**
+ * @brief `rdram:next_pair_*(index)`
+ *
+ * A stateless iterator function for generic `for` loops, like `next()`, e.g.
+ * `for i, v in rdram.next_pair_u32, rdram, nil do ... end`. Starting from
+ * `nil` (or `0`), each call returns the index after the element at `index`
+ * and the value there, until the end of all regions in use. Prefer the
+ * closures returned by `rdram:iter_*()` where possible; they do not have to
+ * re-parse their arguments on every step.
+ */
+static int next_pair_helper(lua_State *L, const ScanType type) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const lua_Integer index = luaL_optinteger(L, 2, 0LL);
+	const lua_Integer type_size = (lua_Integer)scan_type_sizes[type];
+	const lua_Integer next_index = (index <= 0LL) ? 1LL : (index + type_size);
+
+	if ((next_index + type_size - 1LL) > (lua_Integer)(self->regions.limit)) {
+		return 0;
+	}
+
+	const u64 address = (u64)(next_index - 1LL);
+	rdram_prepare(L, self, address, (u64)type_size);
+
+	lua_pushinteger(L, next_index);
+	scan_push_value(L, type, iter_load_bits(self->raw_data, address, type));
 
-	if (key == NULL) {
-		if (methods[0].name == NULL) {
-			return 0;
-		}
+	return 2;
+}
+
+#define IMPL_NEXT_PAIR_METHOD(TYPENAME) \
+int LuaLoader__RDRAM__next_pair_##TYPENAME(lua_State *L) { \
+	return next_pair_helper(L, ScanType_##TYPENAME); \
+}
+
+IMPL_NEXT_PAIR_METHOD(s8)
+IMPL_NEXT_PAIR_METHOD(s16)
+IMPL_NEXT_PAIR_METHOD(s32)
+IMPL_NEXT_PAIR_METHOD(s64)
+IMPL_NEXT_PAIR_METHOD(u8)
+IMPL_NEXT_PAIR_METHOD(u16)
+IMPL_NEXT_PAIR_METHOD(u32)
+IMPL_NEXT_PAIR_METHOD(u64)
+IMPL_NEXT_PAIR_METHOD(f32)
+IMPL_NEXT_PAIR_METHOD(f64)
 
-		lua_pushstring(L, methods[0].name);
-		lua_pushcfunction(L, methods[0].func);
+// The upvalues of the closures returned by `iter_push_closure()`.
+enum {
+	ITER_UPVALUE_SELF = 1,
+	ITER_UPVALUE_CURSOR, // the next 1-based index
+	ITER_UPVALUE_STOP,   // the last index an element may start at
+	ITER_UPVALUE_STEP,
+	ITER_UPVALUE_TYPE,
+	ITER_UPVALUE_COUNT = ITER_UPVALUE_TYPE,
+};
+
+static int iter_next(lua_State *L) {
+	Self *self = lua_touserdata(L, lua_upvalueindex(ITER_UPVALUE_SELF));
+	const lua_Integer cursor = lua_tointeger(L, lua_upvalueindex(ITER_UPVALUE_CURSOR));
+	const lua_Integer stop = lua_tointeger(L, lua_upvalueindex(ITER_UPVALUE_STOP));
+	const lua_Integer step = lua_tointeger(L, lua_upvalueindex(ITER_UPVALUE_STEP));
+	const ScanType type = (ScanType)lua_tointeger(L, lua_upvalueindex(ITER_UPVALUE_TYPE));
+
+	if ((step > 0LL) ? (cursor > stop) : (cursor < stop)) {
+		return 0;
+	}
 
-		return 2;
+	if (self->raw_data == NULL) {
+		return luaL_error(L, "Attempted to iterate over a closed RDRAM instance!");
 	}
 
-	for (size_t i = 0; methods[i].name != NULL; i++) {
-		if (methods[i + 1].name == NULL) {
-			break;
-		}
+	const u64 address = (u64)(cursor - 1LL);
+	rdram_prepare(L, self, address, (u64)scan_type_sizes[type]);
 
-		if (strcmp(key, methods[i].name) == 0) {
-			lua_pushstring(L, methods[i + 1].name);
-			lua_pushcfunction(L, methods[i + 1].func);
+	lua_pushinteger(L, cursor + step);
+	lua_replace(L, lua_upvalueindex(ITER_UPVALUE_CURSOR));
 
-			return 2;
-		}
+	lua_pushinteger(L, cursor);
+	scan_push_value(L, type, iter_load_bits(self->raw_data, address, type));
+
+	return 2;
+}
+
+/**
+ * @brief Push an iterator over the elements of type `type` at `start`,
+ *        `start + step`, ... up to and including `stop` (all 1-based), which
+ *        yields each index together with its value.
+ */
+static void iter_push_closure(
+		lua_State *L,
+		const int self_index,
+		const lua_Integer start,
+		const lua_Integer stop,
+		const lua_Integer step,
+		const ScanType type
+) {
+	lua_pushvalue(L, self_index);
+	lua_pushinteger(L, start);
+	lua_pushinteger(L, stop);
+	lua_pushinteger(L, step);
+	lua_pushinteger(L, (lua_Integer)type);
+	lua_pushcclosure(L, iter_next, ITER_UPVALUE_COUNT);
+}
+
+/**
+ * @brief `rdram:iter_*([start[, stop[, step]]])`
+ *
+ * Iterate over every element whose first byte lies at one of the 1-based
+ * indices `start`, `start + step`, ... and that ends at or before `stop`.
+ * `start` defaults to `1`, `stop` to the end of all regions in use and `step`
+ * to the size of the element type. A negative `step` iterates backwards, in
+ * which case `stop` has to be passed explicitly.
+ *
+ * @return An iterator that yields each index and its value.
+ */
+static int iter_helper(lua_State *L, const ScanType type) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const lua_Integer type_size = (lua_Integer)scan_type_sizes[type];
+
+	const lua_Integer start = luaL_optinteger(L, 2, 1LL);
+	const lua_Integer stop = luaL_optinteger(L, 3, (lua_Integer)(self->regions.limit));
+	const lua_Integer step = luaL_optinteger(L, 4, type_size);
+	luaL_argcheck(L, step != 0LL, 4, "step must not be zero");
+	luaL_argcheck(L, (start >= 1LL) && (start <= self->capacity + 1LL), 2, "index out of range");
+	luaL_argcheck(L, (stop >= 0LL) && (stop <= self->capacity), 3, "index out of range");
+
+	// Convert `stop` to the last index an element may start at.
+	const lua_Integer last = (step > 0LL) ? (stop - type_size + 1LL) : stop;
+	if (step < 0LL) {
+		luaL_argcheck(L, (start + type_size - 1LL) <= self->capacity, 2, "index out of range");
+		luaL_argcheck(L, stop >= 1LL, 3, "index out of range");
+	}
+
+	iter_push_closure(L, 1, start, last, step, type);
+
+	return 1;
+}
+
+#define IMPL_ITER_METHOD(TYPENAME) \
+int LuaLoader__RDRAM__iter_##TYPENAME(lua_State *L) { \
+	return iter_helper(L, ScanType_##TYPENAME); \
+}
+
+IMPL_ITER_METHOD(s8)
+IMPL_ITER_METHOD(s16)
+IMPL_ITER_METHOD(s32)
+IMPL_ITER_METHOD(s64)
+IMPL_ITER_METHOD(u8)
+IMPL_ITER_METHOD(u16)
+IMPL_ITER_METHOD(u32)
+IMPL_ITER_METHOD(u64)
+IMPL_ITER_METHOD(f32)
+IMPL_ITER_METHOD(f64)
+
+
+
+/**
+ * @brief `rdram[index]` or `rdram.method`.
+ *
+ * This is a closure whose only upvalue is the table of methods (see
+ * `luaopen_rdram()`), so looking up a method costs a single `lua_rawget()`.
+ */
+int LuaLoader__RDRAM__index(lua_State *L) {
+	// Method lookups are by far the most common case, so they come first and
+	// skip the type check of argument #1.
+	if (lua_type(L, 2) == LUA_TSTRING) {
+		lua_settop(L, 2);
+		lua_rawget(L, lua_upvalueindex(1));
+		return 1;
+	}
+
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+
+	if (!lua_isinteger(L, 2)) {
+		return luaL_typeerror(L, 2, "integer or string");
+	}
+
+	const lua_Integer index = lua_tointeger(L, 2);
+
+	// The recomp allows N64 code to use up to 512 MiB of RAM. Zero is not a
+	// valid index because Lua uses one-based indexing.
+	ASSERT(
+		(index >= 1) && (index <= self->capacity),
+		"Index out of range! (expected value in range [1, %I], got: %I)",
+		(lua_Integer)(self->capacity),
+		index
+	);
+
+	rdram_prepare(L, self, (u64)(index - 1), 1ULL);
+	lua_pushinteger(L, self->raw_data[RDRAM_INDEX(index - 1)]);
+
+	return 1;
+}
+
+/**
+ * @brief `rdram[index] = byte`, the counterpart of `rdram[index]`. Use the
+ *        `write_value_*()` methods to write wider values.
+ */
+int LuaLoader__RDRAM__newindex(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+
+	if (lua_type(L, 2) != LUA_TNUMBER) {
+		return luaL_error(L, "Cannot assign to field %s of %s!", luaL_tolstring(L, 2, NULL), LuaLoader__RDRAM__name);
 	}
 
+	const lua_Integer index = luaL_checkinteger(L, 2);
+	const lua_Integer value = luaL_checkinteger(L, 3);
+	luaL_argcheck(L, (value >= -128LL) && (value <= 255LL), 3, "value out of range for a byte");
+
+	write_check_range(L, self, index, 1LL);
+	rdram_store_u8(self->raw_data, (u64)(index - 1), (u8)value);
+
 	return 0;
 }
 
+int LuaLoader__RDRAM__tostring(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+
+	AUTO_FREE char *str = NULL;
+	int str_length = asprintf(
+		&str,
+		"<userdata %s at 0x%016"PRIX64" { raw_data: 0x%016"PRIX64", capacity: 0x%08"PRIX64" }>",
+		LuaLoader__RDRAM__name,
+		(u64)self,
+		(u64)(self->raw_data),
+		(u64)(self->capacity)
+	);
+
+	if (str_length < 0) {
+		return luaL_error(L, "Call to `asprintf()` failed! (return code: %d)", str_length);
+	}
+
+	lua_pushlstring(L, str, str_length);
+
+	return 1;
+}
+
+int LuaLoader__RDRAM__len(lua_State *L) {
+	return LuaLoader__RDRAM__get_length(L);
+}
+
+// Enumerates `LuaLoader__RDRAM_methods` in declaration order, keeping its
+// position in an upvalue.
+static int next_method_pair(lua_State *L) {
+	const lua_Integer i = lua_tointeger(L, lua_upvalueindex(1));
+
+	if (LuaLoader__RDRAM_methods[i].name == NULL) {
+		return 0;
+	}
+
+	lua_pushinteger(L, i + 1LL);
+	lua_replace(L, lua_upvalueindex(1));
+
+	lua_pushstring(L, LuaLoader__RDRAM_methods[i].name);
+	lua_pushcfunction(L, LuaLoader__RDRAM_methods[i].func);
+
+	return 2;
+}
+
 int LuaLoader__RDRAM__pairs(lua_State *L) {
 	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
 
-	lua_pushcfunction(L, next_method_pair);
-	lua_pushlightuserdata(L, (void *)LuaLoader__RDRAM_methods);
-	lua_pushnil(L);
+	lua_pushinteger(L, 0LL);
+	lua_pushcclosure(L, next_method_pair, 1);
 
-	return 3;
+	return 1;
 }
 
+/**
+ * @brief `rdram:__ipairs()`, equivalent to `rdram:iter_u8()`. Note that the
+ *        `ipairs()` of Lua 5.4 no longer looks at this metamethod.
+ */
 int LuaLoader__RDRAM__ipairs(lua_State *L) {
 	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
-	TODO;
+	iter_push_closure(L, 1, 1LL, (lua_Integer)(self->regions.limit), 1LL, ScanType_u8);
+	return 1;
+}
+
+/**
+ * @brief `rdram:view(vaddr, length[, type])`
+ *
+ * Create a `LuaLoader::RDRAM::View` of the `length` bytes at `vaddr`, whose
+ * elements are of type `type` (default: `"u8"`). Views are accepted by
+ * `rdram:scan()`, `rdram:copy()` and `rdram:write_bytes()`, so sub-ranges of
+ * memory can be passed around without copying them into Lua strings.
+ */
+int LuaLoader__RDRAM__view(lua_State *L) {
+	Self *self = luaL_checkudata(L, 1, LuaLoader__RDRAM__name);
+	const lua_Integer length = luaL_checkinteger(L, 3);
+	const ScanType type = (ScanType)luaL_checkoption(L, 4, "u8", scan_type_names);
+	const lua_Integer type_size = (lua_Integer)scan_type_sizes[type];
+
+	luaL_argcheck(L, (length >= 0LL) && (length <= self->capacity), 3, "length out of range");
+	luaL_argcheck(L, (length % type_size) == 0LL, 3, "length must be a multiple of the size of the type");
+	const u64 address = vaddr_check(L, self, 2, (u64)length);
+	luaL_argcheck(L, (address % (u64)type_size) == 0ULL, 2, "address must be aligned to the size of the type");
+
+	View *view = lua_newuserdatauv(L, sizeof(View), 1);
+	*view = (View){ .address = address, .length = length, .type = type };
+	luaL_setmetatable(L, LuaLoader__RDRAM__View__name);
+
+	lua_pushvalue(L, 1);
+	lua_setiuservalue(L, -2, 1);
+
+	return 1;
+}
+
+/**
+ * @brief `view:get_address()`
+ * @return The KSEG0 address of the first byte of `view`.
+ */
+int LuaLoader__RDRAM__View__get_address(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+	lua_pushinteger(L, (lua_Integer)(0x80000000ULL | view->address));
+	return 1;
+}
+
+/**
+ * @brief `view:get_length()`
+ * @return The length of `view` in bytes; `#view` is the number of elements.
+ */
+int LuaLoader__RDRAM__View__get_length(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+	lua_pushinteger(L, view->length);
+	return 1;
+}
+
+int LuaLoader__RDRAM__View__get_type(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+	lua_pushstring(L, scan_type_names[view->type]);
+	return 1;
+}
+
+/**
+ * @brief `view:read_value(type, index)`
+ *
+ * Read a value of any type at the 1-based byte `index` within `view`,
+ * regardless of the type of its elements.
+ */
+int LuaLoader__RDRAM__View__read_value(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+	const ScanType type = (ScanType)luaL_checkoption(L, 2, NULL, scan_type_names);
+	const lua_Integer index = luaL_checkinteger(L, 3);
+	const lua_Integer type_size = (lua_Integer)scan_type_sizes[type];
+
+	ASSERT(
+		(index >= 1) && (index <= view->length - type_size + 1),
+		"Index out of range! (expected value in range [1, %I], got: %I)",
+		(lua_Integer)(view->length - type_size + 1),
+		index
+	);
+
+	const u64 address = view->address + (u64)(index - 1);
+	rdram_prepare(L, parent, address, (u64)type_size);
+	scan_push_value(L, type, iter_load_bits(parent->raw_data, address, type));
+
+	return 1;
+}
+
+/**
+ * @brief `view:to_string()`
+ * @return A copy of the contents of `view`, in N64 byte order.
+ */
+int LuaLoader__RDRAM__View__to_string(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+	const size_t length = (size_t)(view->length);
+
+	rdram_prepare(L, parent, view->address, (u64)length);
+
+	luaL_Buffer buffer;
+	char *data = luaL_buffinitsize(L, &buffer, length);
+	rdram_read_bytes((u8 *)data, parent->raw_data, view->address, length);
+	luaL_pushresultsize(&buffer, length);
+
+	return 1;
+}
+
+/**
+ * @brief `view:hash([seed])`
+ * @return The same hash as for the bytes of `view:to_string()`, so views with
+ *         equal contents hash equally no matter where they are.
+ */
+int LuaLoader__RDRAM__View__hash(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+	const u64 seed = (u64)luaL_optinteger(L, 2, 0LL);
+	const size_t length = (size_t)(view->length);
+
+	rdram_prepare(L, parent, view->address, (u64)length);
+
+	u8 buffer[VIEW_CHUNK_LENGTH];
+	u64 hash = hash_begin(length, seed);
+	for (size_t done = 0ULL; done < length;) {
+		const size_t chunk_length = ((length - done) < VIEW_CHUNK_LENGTH) ? (length - done) : VIEW_CHUNK_LENGTH;
+		rdram_read_bytes(buffer, parent->raw_data, view->address + done, chunk_length);
+		hash = hash_update(hash, buffer, chunk_length);
+		done += chunk_length;
+	}
+
+	lua_pushinteger(L, (lua_Integer)hash_finish(hash));
+
+	return 1;
+}
+
+/**
+ * @brief `view:compress()`
+ * @return The contents of `view` compressed with the same codec as snapshot
+ *         pages, or `nil` if that would not make them any smaller. See
+ *         `rdram.decompress()`.
+ */
+int LuaLoader__RDRAM__View__compress(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+	const size_t length = (size_t)(view->length);
+
+	if (length == 0ULL) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	rdram_prepare(L, parent, view->address, (u64)length);
+
+	// Set up the buffer first; it may raise an error, which would leak `data`.
+	luaL_Buffer buffer;
+	char *compressed = luaL_buffinitsize(L, &buffer, length - 1ULL);
+
+	AUTO_FREE u8 *data = (u8 *)malloc(length);
+	if (data == NULL) {
+		return luaL_error(L, "Failed to allocate memory for a copy of the view!");
+	}
+	rdram_read_bytes(data, parent->raw_data, view->address, length);
+
+	const size_t compressed_length = lz_compress(data, length, (u8 *)compressed, length - 1ULL);
+	if (compressed_length == 0ULL) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	luaL_pushresultsize(&buffer, compressed_length);
+
+	return 1;
+}
+
+/**
+ * @brief `view:write_to_file(file_path)`
+ *
+ * Write the contents of `view` to a file, in N64 byte order.
+ *
+ * @return `true` on success, or `nil`, an error message and an error code
+ *         (like `io.open()`).
+ */
+int LuaLoader__RDRAM__View__write_to_file(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+	const char *file_path = luaL_checkstring(L, 2);
+	const size_t length = (size_t)(view->length);
+
+	// May raise an error, so it has to happen before opening the file.
+	rdram_prepare(L, parent, view->address, (u64)length);
+
+	FILE *file = fopen(file_path, "wb");
+	if (file == NULL) {
+		return luaL_fileresult(L, 0, file_path);
+	}
+
+	u8 buffer[VIEW_CHUNK_LENGTH];
+	bool success = true;
+	for (size_t done = 0ULL; success && (done < length);) {
+		const size_t chunk_length = ((length - done) < VIEW_CHUNK_LENGTH) ? (length - done) : VIEW_CHUNK_LENGTH;
+		rdram_read_bytes(buffer, parent->raw_data, view->address + done, chunk_length);
+		success = fwrite(buffer, sizeof(u8), chunk_length, file) == chunk_length;
+		done += chunk_length;
+	}
+
+	success = (fclose(file) == 0) && success;
+
+	return luaL_fileresult(L, success, file_path);
+}
+
+/**
+ * @brief `view[index]` or `view.method`, where `index` counts elements, not
+ *        bytes. Works like `LuaLoader__RDRAM__index()`.
+ */
+int LuaLoader__RDRAM__View__index(lua_State *L) {
+	if (lua_type(L, 2) == LUA_TSTRING) {
+		lua_settop(L, 2);
+		lua_rawget(L, lua_upvalueindex(1));
+		return 1;
+	}
+
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+
+	if (!lua_isinteger(L, 2)) {
+		return luaL_typeerror(L, 2, "integer or string");
+	}
+
+	const lua_Integer index = lua_tointeger(L, 2);
+	const lua_Integer type_size = (lua_Integer)scan_type_sizes[view->type];
+	const lua_Integer count = view->length / type_size;
+
+	ASSERT(
+		(index >= 1) && (index <= count),
+		"Index out of range! (expected value in range [1, %I], got: %I)",
+		count,
+		index
+	);
+
+	const u64 address = view->address + (u64)((index - 1) * type_size);
+	rdram_prepare(L, parent, address, (u64)type_size);
+	scan_push_value(L, view->type, iter_load_bits(parent->raw_data, address, view->type));
+
+	return 1;
+}
+
+/**
+ * @brief `view[index] = value`, the counterpart of `view[index]`.
+ */
+int LuaLoader__RDRAM__View__newindex(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+
+	if (lua_type(L, 2) != LUA_TNUMBER) {
+		return luaL_error(L, "Cannot assign to field %s of %s!", luaL_tolstring(L, 2, NULL), LuaLoader__RDRAM__View__name);
+	}
+
+	const lua_Integer index = luaL_checkinteger(L, 2);
+	const lua_Integer type_size = (lua_Integer)scan_type_sizes[view->type];
+	const lua_Integer count = view->length / type_size;
+
+	ASSERT(
+		(index >= 1) && (index <= count),
+		"Index out of range! (expected value in range [1, %I], got: %I)",
+		count,
+		index
+	);
+
+	const u64 value_bits = scan_check_value(L, 3, view->type);
+	const lua_Integer rdram_index = (lua_Integer)(view->address) + ((index - 1) * type_size) + 1;
+	write_value_helper(L, parent, rdram_index, (int_fast8_t)type_size, value_bits);
+
+	return 0;
+}
+
+int LuaLoader__RDRAM__View__len(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+	lua_pushinteger(L, view->length / (lua_Integer)scan_type_sizes[view->type]);
+	return 1;
+}
+
+/**
+ * @brief Compare the contents of the views at arguments 1 and 2 like
+ *        `memcmp()`, where a view that is a prefix of the other one is less.
+ */
+static int view_compare(lua_State *L) {
+	Self *a_parent = NULL;
+	Self *b_parent = NULL;
+	const View *a = view_check(L, 1, &a_parent);
+	const View *b = view_check(L, 2, &b_parent);
+	const size_t length = (size_t)((a->length < b->length) ? a->length : b->length);
+
+	const bool is_same_memory = (a_parent->raw_data == b_parent->raw_data) && (a->address == b->address);
+	if (!is_same_memory) {
+		rdram_prepare(L, a_parent, a->address, (u64)length);
+		rdram_prepare(L, b_parent, b->address, (u64)length);
+
+		u8 a_buffer[VIEW_CHUNK_LENGTH];
+		u8 b_buffer[VIEW_CHUNK_LENGTH];
+		for (size_t done = 0ULL; done < length;) {
+			const size_t chunk_length = ((length - done) < VIEW_CHUNK_LENGTH) ? (length - done) : VIEW_CHUNK_LENGTH;
+			rdram_read_bytes(a_buffer, a_parent->raw_data, a->address + done, chunk_length);
+			rdram_read_bytes(b_buffer, b_parent->raw_data, b->address + done, chunk_length);
+
+			const int result = memcmp(a_buffer, b_buffer, chunk_length);
+			if (result != 0) {
+				return result;
+			}
+
+			done += chunk_length;
+		}
+	}
+
+	return (a->length > b->length) - (a->length < b->length);
+}
+
+/**
+ * @brief `view == other`, `true` if both have the same contents (like strings,
+ *        regardless of where they are and the type of their elements).
+ */
+int LuaLoader__RDRAM__View__eq(lua_State *L) {
+	lua_pushboolean(L, view_compare(L) == 0);
+	return 1;
+}
+
+int LuaLoader__RDRAM__View__lt(lua_State *L) {
+	lua_pushboolean(L, view_compare(L) < 0);
+	return 1;
+}
+
+int LuaLoader__RDRAM__View__le(lua_State *L) {
+	lua_pushboolean(L, view_compare(L) <= 0);
+	return 1;
+}
+
+int LuaLoader__RDRAM__View__tostring(lua_State *L) {
+	Self *parent = NULL;
+	const View *view = view_check(L, 1, &parent);
+
+	AUTO_FREE char *str = NULL;
+	int str_length = asprintf(
+		&str,
+		"<userdata %s at 0x%016"PRIX64" { address: 0x%08"PRIX64", length: 0x%08"PRIX64", type: %s }>",
+		LuaLoader__RDRAM__View__name,
+		(u64)view,
+		(u64)(0x80000000ULL | view->address),
+		(u64)(view->length),
+		scan_type_names[view->type]
+	);
+
+	if (str_length < 0) {
+		return luaL_error(L, "Call to `asprintf()` failed! (return code: %d)", str_length);
+	}
+
+	lua_pushlstring(L, str, str_length);
+
+	return 1;
+}
+
+/**
+ * @brief `rdram.decompress(data, length)`, the inverse of `view:compress()`.
+ * @return The `length` bytes that `data` decompresses to.
+ */
+int LuaLoader__RDRAM__decompress(lua_State *L) {
+	size_t compressed_length = 0ULL;
+	const char *compressed = luaL_checklstring(L, 1, &compressed_length);
+	const lua_Integer length = luaL_checkinteger(L, 2);
+	luaL_argcheck(L, length >= 0LL, 2, "length must not be negative");
+
+	luaL_Buffer buffer;
+	char *data = luaL_buffinitsize(L, &buffer, (size_t)length);
+	if (!lz_decompress((const u8 *)compressed, compressed_length, (u8 *)data, (size_t)length)) {
+		return luaL_error(L, "Data is corrupt or does not decompress to %I bytes!", length);
+	}
+	luaL_pushresultsize(&buffer, (size_t)length);
+
 	return 1;
 }
 
@@ -479,39 +2487,43 @@ int luaopen_rdram(lua_State *L) {
 	if (luaL_newmetatable(L, LuaLoader__RDRAM__name)) {
 		luaL_setfuncs(L, LuaLoader__RDRAM_meta_methods, 0);
 
-		lua_pushstring(L, "__methods__");
 		lua_createtable(L, 0, sizeof(LuaLoader__RDRAM_methods) / sizeof(luaL_Reg) - 1);
 		luaL_setfuncs(L, LuaLoader__RDRAM_methods, 0);
-		lua_rawset(L, -3);
-	}
 
-	/* lua_pushstring(L, "__index"); */
+		lua_pushstring(L, "__methods__");
+		lua_pushvalue(L, -2);
+		lua_rawset(L, -4);
 
-	/* lua_createtable(L, 0, 1); {
+		// `__index` cannot simply be the table of methods, because a fallback
+		// for integer keys set on that table would not get to see the
+		// userdata. Instead, `LuaLoader__RDRAM__index()` keeps the table as an
+		// upvalue and looks up string keys there directly.
 		lua_pushstring(L, "__index");
-		lua_pushcfunction(L, LuaLoader__RDRAM__index);
+		lua_rotate(L, -2, 1);
+		lua_pushcclosure(L, LuaLoader__RDRAM__index, 1);
 		lua_rawset(L, -3);
-	}; lua_setmetatable(L, -2); */
+	}
 
-	// Set the table containing normal / non-meta methods as the `__index` field
-	// of the `LuaLoader::RDRAM` metatable. If the given key cannot be found in
-	// this `__index`-table, `LuaLoader__RDRAM__index()` will be invoked.
-	/* lua_rawset(L, -3); */
+	if (luaL_newmetatable(L, LuaLoader__RDRAM__View__name)) {
+		luaL_setfuncs(L, LuaLoader__RDRAM__View_meta_methods, 0);
 
-	//lua_createtable(L, 0, 1);
+		lua_pushstring(L, "__index");
+		luaL_newlib(L, LuaLoader__RDRAM__View_methods);
+		lua_pushcclosure(L, LuaLoader__RDRAM__View__index, 1);
+		lua_rawset(L, -3);
+	}
+	lua_pop(L, 1);
 
-	size_t rdram_length = 0x20000000ULL;
-	u8 *rdram = (u8 *)malloc(rdram_length * sizeof(u8));
+	if (luaL_newmetatable(L, LuaLoader__RDRAM__ScanResult__name)) {
+		luaL_setfuncs(L, LuaLoader__RDRAM__ScanResult_meta_methods, 0);
 
-	FILE *rdram_dump_file = fopen("./rdram-dump.bin", "rb");
-	if (rdram_dump_file != NULL) {
-		fread(rdram, sizeof(u8), rdram_length, rdram_dump_file);
-		fclose(rdram_dump_file);
+		lua_pushstring(L, "__index");
+		luaL_newlib(L, LuaLoader__RDRAM__ScanResult_methods);
+		lua_rawset(L, -3);
 	}
+	lua_pop(L, 1);
 
-	//lua_pushstring(L, "rdram");
-	LuaLoader__RDRAM__new(L, rdram, rdram_length);
-	//lua_rawset(L, -3);
+	luaL_newlib(L, LuaLoader__RDRAM_module_functions);
 
 	return 1;
 }
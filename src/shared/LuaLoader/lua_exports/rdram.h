@@ -18,23 +18,57 @@
 #include "../lua/src/lauxlib.h"
 
 #include "../mod_recomp.h"
+#include "../utils/regions.h"
 #include "../utils/types.h"
+#include "../utils/value_scan.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
+typedef struct LuaLoader__RDRAM__Pager LuaLoader__RDRAM__Pager;
+
 typedef struct LuaLoader__RDRAM {
 	u8 *raw_data;
 	lua_Integer capacity;
+	lua_Integer cached_length; // see `rdram_count_length()`
+	u64 cached_length_epoch;
+	RDRAMRegionMap regions;
+	bool is_read_only;
+	void *mapping; // owned by this instance if not NULL, see `LuaLoader__RDRAM__open()`
+	size_t mapping_size;
+	LuaLoader__RDRAM__Pager *pager; // only set for snapshots, see `rdram_prepare()`
 } LuaLoader__RDRAM;
 
 #define LuaLoader__RDRAM__name "LuaLoader::RDRAM"
 
+typedef struct LuaLoader__RDRAM__ScanResult {
+	ScanResultSet set;
+} LuaLoader__RDRAM__ScanResult;
+
+#define LuaLoader__RDRAM__ScanResult__name "LuaLoader::RDRAM::ScanResult"
+
+/**
+ * A typed window into the memory of a `LuaLoader::RDRAM` instance, which is
+ * kept alive through the first user value. Nothing gets copied; reads always
+ * see the current contents.
+ */
+typedef struct LuaLoader__RDRAM__View {
+	u64 address; // 0-based offset into `raw_data`
+	lua_Integer length; // in bytes, always a multiple of the size of `type`
+	ScanType type;
+} LuaLoader__RDRAM__View;
+
+#define LuaLoader__RDRAM__View__name "LuaLoader::RDRAM::View"
+
 int LuaLoader__RDRAM__new(lua_State *L, u8 *rdram, lua_Integer capacity) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__open(lua_State *L) __attribute__((__nonnull__));
 
 int LuaLoader__RDRAM__get_length(lua_State *L) __attribute__((__nonnull__)); // formerly `get_occupied_length`
 int LuaLoader__RDRAM__get_capacity(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__get_data_as_string(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__get_raw_data_as_string(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__get_regions(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__refresh_regions(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_snapshot(lua_State *L) __attribute__((__nonnull__));
 //int LuaLoader__RDRAM__get_data_as_table(lua_State *L) __attribute__((__nonnull__));
 //int LuaLoader__RDRAM__get_raw_data_as_table(lua_State *L) __attribute__((__nonnull__));
 
@@ -49,6 +83,54 @@ int LuaLoader__RDRAM__read_value_u64(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__read_value_f32(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__read_value_f64(lua_State *L) __attribute__((__nonnull__));
 
+int LuaLoader__RDRAM__read_array_s8(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__read_array_s16(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__read_array_s32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__read_array_s64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__read_array_u8(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__read_array_u16(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__read_array_u32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__read_array_u64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__read_array_f32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__read_array_f64(lua_State *L) __attribute__((__nonnull__));
+
+int LuaLoader__RDRAM__s8(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__s16(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__s32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__s64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__u8(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__u16(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__u32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__u64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__f32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__f64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__vec3f(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__vec3s(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__posrot(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__mtxf(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__cstring(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__bytes(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__view(lua_State *L) __attribute__((__nonnull__));
+
+int LuaLoader__RDRAM__write_value_s8(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_value_s16(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_value_s32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_value_s64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_value_u8(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_value_u16(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_value_u32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_value_u64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_value_f32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_value_f64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__write_bytes(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__fill(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__copy(lua_State *L) __attribute__((__nonnull__));
+
+int LuaLoader__RDRAM__scan(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__find_pattern(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__match(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__gmatch(lua_State *L) __attribute__((__nonnull__));
+
 int LuaLoader__RDRAM__next_pair_s8(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__next_pair_s16(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__next_pair_s32(lua_State *L) __attribute__((__nonnull__));
@@ -60,12 +142,49 @@ int LuaLoader__RDRAM__next_pair_u64(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__next_pair_f32(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__next_pair_f64(lua_State *L) __attribute__((__nonnull__));
 
+int LuaLoader__RDRAM__iter_s8(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__iter_s16(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__iter_s32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__iter_s64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__iter_u8(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__iter_u16(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__iter_u32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__iter_u64(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__iter_f32(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__iter_f64(lua_State *L) __attribute__((__nonnull__));
+
 int LuaLoader__RDRAM__index(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__newindex(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__tostring(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__len(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__pairs(lua_State *L) __attribute__((__nonnull__));
 int LuaLoader__RDRAM__ipairs(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__gc(lua_State *L) __attribute__((__nonnull__));
+
+int LuaLoader__RDRAM__ScanResult__refine(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__ScanResult__count(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__ScanResult__get(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__ScanResult__to_table(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__ScanResult__tostring(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__ScanResult__gc(lua_State *L) __attribute__((__nonnull__));
+
+int LuaLoader__RDRAM__View__get_address(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__get_length(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__get_type(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__read_value(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__to_string(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__hash(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__compress(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__write_to_file(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__index(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__newindex(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__len(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__eq(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__lt(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__le(lua_State *L) __attribute__((__nonnull__));
+int LuaLoader__RDRAM__View__tostring(lua_State *L) __attribute__((__nonnull__));
+
+int LuaLoader__RDRAM__decompress(lua_State *L) __attribute__((__nonnull__));
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -74,6 +193,9 @@ static const luaL_Reg LuaLoader__RDRAM_methods[] = {
 	{ "get_capacity",           LuaLoader__RDRAM__get_capacity           },
 	{ "get_data_as_string",     LuaLoader__RDRAM__get_data_as_string     },
 	{ "get_raw_data_as_string", LuaLoader__RDRAM__get_raw_data_as_string },
+	{ "get_regions",            LuaLoader__RDRAM__get_regions            },
+	{ "refresh_regions",        LuaLoader__RDRAM__refresh_regions        },
+	{ "write_snapshot",         LuaLoader__RDRAM__write_snapshot         },
 	//{ "get_data_as_table",      LuaLoader__RDRAM__get_data_as_table     },
 	//{ "get_raw_data_as_table",  LuaLoader__RDRAM__get_raw_data_as_table },
 	{ "read_value_s8",          LuaLoader__RDRAM__read_value_s8          },
@@ -86,6 +208,50 @@ static const luaL_Reg LuaLoader__RDRAM_methods[] = {
 	{ "read_value_u64",         LuaLoader__RDRAM__read_value_u64         },
 	{ "read_value_f32",         LuaLoader__RDRAM__read_value_f32         },
 	{ "read_value_f64",         LuaLoader__RDRAM__read_value_f64         },
+	{ "read_array_s8",          LuaLoader__RDRAM__read_array_s8          },
+	{ "read_array_s16",         LuaLoader__RDRAM__read_array_s16         },
+	{ "read_array_s32",         LuaLoader__RDRAM__read_array_s32         },
+	{ "read_array_s64",         LuaLoader__RDRAM__read_array_s64         },
+	{ "read_array_u8",          LuaLoader__RDRAM__read_array_u8          },
+	{ "read_array_u16",         LuaLoader__RDRAM__read_array_u16         },
+	{ "read_array_u32",         LuaLoader__RDRAM__read_array_u32         },
+	{ "read_array_u64",         LuaLoader__RDRAM__read_array_u64         },
+	{ "read_array_f32",         LuaLoader__RDRAM__read_array_f32         },
+	{ "read_array_f64",         LuaLoader__RDRAM__read_array_f64         },
+	{ "s8",                     LuaLoader__RDRAM__s8                     },
+	{ "s16",                    LuaLoader__RDRAM__s16                    },
+	{ "s32",                    LuaLoader__RDRAM__s32                    },
+	{ "s64",                    LuaLoader__RDRAM__s64                    },
+	{ "u8",                     LuaLoader__RDRAM__u8                     },
+	{ "u16",                    LuaLoader__RDRAM__u16                    },
+	{ "u32",                    LuaLoader__RDRAM__u32                    },
+	{ "u64",                    LuaLoader__RDRAM__u64                    },
+	{ "f32",                    LuaLoader__RDRAM__f32                    },
+	{ "f64",                    LuaLoader__RDRAM__f64                    },
+	{ "vec3f",                  LuaLoader__RDRAM__vec3f                  },
+	{ "vec3s",                  LuaLoader__RDRAM__vec3s                  },
+	{ "posrot",                 LuaLoader__RDRAM__posrot                 },
+	{ "mtxf",                   LuaLoader__RDRAM__mtxf                   },
+	{ "cstring",                LuaLoader__RDRAM__cstring                },
+	{ "bytes",                  LuaLoader__RDRAM__bytes                  },
+	{ "view",                   LuaLoader__RDRAM__view                   },
+	{ "write_value_s8",         LuaLoader__RDRAM__write_value_s8         },
+	{ "write_value_s16",        LuaLoader__RDRAM__write_value_s16        },
+	{ "write_value_s32",        LuaLoader__RDRAM__write_value_s32        },
+	{ "write_value_s64",        LuaLoader__RDRAM__write_value_s64        },
+	{ "write_value_u8",         LuaLoader__RDRAM__write_value_u8         },
+	{ "write_value_u16",        LuaLoader__RDRAM__write_value_u16        },
+	{ "write_value_u32",        LuaLoader__RDRAM__write_value_u32        },
+	{ "write_value_u64",        LuaLoader__RDRAM__write_value_u64        },
+	{ "write_value_f32",        LuaLoader__RDRAM__write_value_f32        },
+	{ "write_value_f64",        LuaLoader__RDRAM__write_value_f64        },
+	{ "write_bytes",            LuaLoader__RDRAM__write_bytes            },
+	{ "fill",                   LuaLoader__RDRAM__fill                   },
+	{ "copy",                   LuaLoader__RDRAM__copy                   },
+	{ "scan",                   LuaLoader__RDRAM__scan                   },
+	{ "find_pattern",           LuaLoader__RDRAM__find_pattern           },
+	{ "match",                  LuaLoader__RDRAM__match                  },
+	{ "gmatch",                 LuaLoader__RDRAM__gmatch                 },
 	{ "next_pair_s8",           LuaLoader__RDRAM__next_pair_s8           },
 	{ "next_pair_s16",          LuaLoader__RDRAM__next_pair_s16          },
 	{ "next_pair_s32",          LuaLoader__RDRAM__next_pair_s32          },
@@ -96,19 +262,74 @@ static const luaL_Reg LuaLoader__RDRAM_methods[] = {
 	{ "next_pair_u64",          LuaLoader__RDRAM__next_pair_u64          },
 	{ "next_pair_f32",          LuaLoader__RDRAM__next_pair_f32          },
 	{ "next_pair_f64",          LuaLoader__RDRAM__next_pair_f64          },
+	{ "iter_s8",                LuaLoader__RDRAM__iter_s8                },
+	{ "iter_s16",               LuaLoader__RDRAM__iter_s16               },
+	{ "iter_s32",               LuaLoader__RDRAM__iter_s32               },
+	{ "iter_s64",               LuaLoader__RDRAM__iter_s64               },
+	{ "iter_u8",                LuaLoader__RDRAM__iter_u8                },
+	{ "iter_u16",               LuaLoader__RDRAM__iter_u16               },
+	{ "iter_u32",               LuaLoader__RDRAM__iter_u32               },
+	{ "iter_u64",               LuaLoader__RDRAM__iter_u64               },
+	{ "iter_f32",               LuaLoader__RDRAM__iter_f32               },
+	{ "iter_f64",               LuaLoader__RDRAM__iter_f64               },
 	{ NULL,                     NULL                                     },
 };
 
+// `__index` is not listed here; it needs an upvalue, see `luaopen_rdram()`.
 static const luaL_Reg LuaLoader__RDRAM_meta_methods[] = {
-	{ "__index",    LuaLoader__RDRAM__index    },
 	{ "__newindex", LuaLoader__RDRAM__newindex },
 	{ "__tostring", LuaLoader__RDRAM__tostring },
 	{ "__len",      LuaLoader__RDRAM__len      },
 	{ "__pairs",    LuaLoader__RDRAM__pairs    },
 	{ "__ipairs",   LuaLoader__RDRAM__ipairs   },
+	{ "__gc",       LuaLoader__RDRAM__gc       },
 	{ NULL,         NULL                       },
 };
 
+static const luaL_Reg LuaLoader__RDRAM__ScanResult_methods[] = {
+	{ "refine",   LuaLoader__RDRAM__ScanResult__refine   },
+	{ "count",    LuaLoader__RDRAM__ScanResult__count    },
+	{ "get",      LuaLoader__RDRAM__ScanResult__get      },
+	{ "to_table", LuaLoader__RDRAM__ScanResult__to_table },
+	{ NULL,       NULL                                   },
+};
+
+static const luaL_Reg LuaLoader__RDRAM__ScanResult_meta_methods[] = {
+	{ "__len",      LuaLoader__RDRAM__ScanResult__count    },
+	{ "__tostring", LuaLoader__RDRAM__ScanResult__tostring },
+	{ "__gc",       LuaLoader__RDRAM__ScanResult__gc       },
+	{ NULL,         NULL                                   },
+};
+
+static const luaL_Reg LuaLoader__RDRAM__View_methods[] = {
+	{ "get_address",   LuaLoader__RDRAM__View__get_address   },
+	{ "get_length",    LuaLoader__RDRAM__View__get_length    },
+	{ "get_type",      LuaLoader__RDRAM__View__get_type      },
+	{ "read_value",    LuaLoader__RDRAM__View__read_value    },
+	{ "to_string",     LuaLoader__RDRAM__View__to_string     },
+	{ "hash",          LuaLoader__RDRAM__View__hash          },
+	{ "compress",      LuaLoader__RDRAM__View__compress      },
+	{ "write_to_file", LuaLoader__RDRAM__View__write_to_file },
+	{ NULL,            NULL                                  },
+};
+
+// `__index` is not listed here either, see `luaopen_rdram()`.
+static const luaL_Reg LuaLoader__RDRAM__View_meta_methods[] = {
+	{ "__newindex", LuaLoader__RDRAM__View__newindex },
+	{ "__len",      LuaLoader__RDRAM__View__len      },
+	{ "__eq",       LuaLoader__RDRAM__View__eq       },
+	{ "__lt",       LuaLoader__RDRAM__View__lt       },
+	{ "__le",       LuaLoader__RDRAM__View__le       },
+	{ "__tostring", LuaLoader__RDRAM__View__tostring },
+	{ NULL,         NULL                             },
+};
+
+static const luaL_Reg LuaLoader__RDRAM_module_functions[] = {
+	{ "open",       LuaLoader__RDRAM__open       },
+	{ "decompress", LuaLoader__RDRAM__decompress },
+	{ NULL,         NULL                         },
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #endif
@@ -28,6 +28,9 @@ end))
 ---@field get_capacity           fun(self: self)
 ---@field get_data_as_string     fun(self: self)
 ---@field get_raw_data_as_string fun(self: self)
+---@field get_regions            fun(self: self): { name: string, start: integer, stop: integer }[]
+---@field refresh_regions        fun(self: self): { name: string, start: integer, stop: integer }[]
+---@field write_snapshot         fun(self: self, file_path: string, base?: LuaLoader.RDRAM, base_path?: string): boolean?, string?, integer?
 ---@field get_data_as_table      fun(self: self)
 ---@field get_raw_data_as_table  fun(self: self)
 ---@field read_value_s8          fun(self: self, index: integer): integer
@@ -38,8 +41,52 @@ end))
 ---@field read_value_u16         fun(self: self, index: integer): integer
 ---@field read_value_u32         fun(self: self, index: integer): integer
 ---@field read_value_u64         fun(self: self, index: integer): integer
----@field read_value_f32         fun(self: self, index: integer): integer
----@field read_value_f64         fun(self: self, index: integer): integer
+---@field read_value_f32         fun(self: self, index: integer): number
+---@field read_value_f64         fun(self: self, index: integer): number
+---@field read_array_s8          fun(self: self, index: integer, count: integer): integer[]
+---@field read_array_s16         fun(self: self, index: integer, count: integer): integer[]
+---@field read_array_s32         fun(self: self, index: integer, count: integer): integer[]
+---@field read_array_s64         fun(self: self, index: integer, count: integer): integer[]
+---@field read_array_u8          fun(self: self, index: integer, count: integer): integer[]
+---@field read_array_u16         fun(self: self, index: integer, count: integer): integer[]
+---@field read_array_u32         fun(self: self, index: integer, count: integer): integer[]
+---@field read_array_u64         fun(self: self, index: integer, count: integer): integer[]
+---@field read_array_f32         fun(self: self, index: integer, count: integer): number[]
+---@field read_array_f64         fun(self: self, index: integer, count: integer): number[]
+---@field s8                     fun(self: self, vaddr: integer): integer
+---@field s16                    fun(self: self, vaddr: integer): integer
+---@field s32                    fun(self: self, vaddr: integer): integer
+---@field s64                    fun(self: self, vaddr: integer): integer
+---@field u8                     fun(self: self, vaddr: integer): integer
+---@field u16                    fun(self: self, vaddr: integer): integer
+---@field u32                    fun(self: self, vaddr: integer): integer
+---@field u64                    fun(self: self, vaddr: integer): integer
+---@field f32                    fun(self: self, vaddr: integer): number
+---@field f64                    fun(self: self, vaddr: integer): number
+---@field vec3f                  fun(self: self, vaddr: integer): number, number, number
+---@field vec3s                  fun(self: self, vaddr: integer): integer, integer, integer
+---@field posrot                 fun(self: self, vaddr: integer): number, number, number, integer, integer, integer
+---@field mtxf                   fun(self: self, vaddr: integer): number, number, number, number, number, number, number, number, number, number, number, number, number, number, number, number
+---@field cstring                fun(self: self, vaddr: integer, max_length?: integer): string
+---@field bytes                  fun(self: self, vaddr: integer, count: integer): string
+---@field view                   fun(self: self, vaddr: integer, length: integer, type?: LuaLoader.RDRAM.ScanType): LuaLoader.RDRAM.View
+---@field write_value_s8         fun(self: self, index: integer, value: integer)
+---@field write_value_s16        fun(self: self, index: integer, value: integer)
+---@field write_value_s32        fun(self: self, index: integer, value: integer)
+---@field write_value_s64        fun(self: self, index: integer, value: integer)
+---@field write_value_u8         fun(self: self, index: integer, value: integer)
+---@field write_value_u16        fun(self: self, index: integer, value: integer)
+---@field write_value_u32        fun(self: self, index: integer, value: integer)
+---@field write_value_u64        fun(self: self, index: integer, value: integer)
+---@field write_value_f32        fun(self: self, index: integer, value: number)
+---@field write_value_f64        fun(self: self, index: integer, value: number)
+---@field write_bytes            fun(self: self, index: integer, data: string|LuaLoader.RDRAM.View)
+---@field fill                   fun(self: self, index: integer, count: integer, value: integer|string)
+---@field copy                   fun(self: self, dst: integer, src: integer|LuaLoader.RDRAM.View, count?: integer)
+---@field scan                   fun(self: self, type: LuaLoader.RDRAM.ScanType, predicate: LuaLoader.RDRAM.ScanPredicate, value?: number, start?: integer|LuaLoader.RDRAM.View, stop?: integer): LuaLoader.RDRAM.ScanResult
+---@field find_pattern           fun(self: self, pattern: string, start?: integer, stop?: integer): (fun(): integer?)
+---@field match                  fun(self: self, pattern: string, start?: integer, stop?: integer): (string|integer)?, ...
+---@field gmatch                 fun(self: self, pattern: string, start?: integer, stop?: integer): (fun(): (string|integer), ...)
 ---@field next_pair_s8           fun(self: self, index: integer): (integer, integer)?
 ---@field next_pair_s16          fun(self: self, index: integer): (integer, integer)?
 ---@field next_pair_s32          fun(self: self, index: integer): (integer, integer)?
@@ -50,7 +97,147 @@ end))
 ---@field next_pair_u64          fun(self: self, index: integer): (integer, integer)?
 ---@field next_pair_f32          fun(self: self, index: integer): (integer, integer)?
 ---@field next_pair_f64          fun(self: self, index: integer): (integer, integer)?
-local rdram = require("rdram")
+---@field iter_s8                fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, integer)
+---@field iter_s16               fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, integer)
+---@field iter_s32               fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, integer)
+---@field iter_s64               fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, integer)
+---@field iter_u8                fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, integer)
+---@field iter_u16               fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, integer)
+---@field iter_u32               fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, integer)
+---@field iter_u64               fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, integer)
+---@field iter_f32               fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, number)
+---@field iter_f64               fun(self: self, start?: integer, stop?: integer, step?: integer): (fun(): integer, number)
+---@alias LuaLoader.RDRAM.ScanType "s8"|"s16"|"s32"|"s64"|"u8"|"u16"|"u32"|"u64"|"f32"|"f64"
+---@alias LuaLoader.RDRAM.ScanPredicate "=="|"~="|"<"|"<="|">"|">="|"any"|"changed"|"unchanged"|"increased"|"decreased"
+---@class LuaLoader.RDRAM.ScanResult : userdata
+---@field refine   fun(self: self, predicate: LuaLoader.RDRAM.ScanPredicate, value?: number): self
+---@field count    fun(self: self): integer
+---@field get      fun(self: self, i: integer): (integer, number)?
+---@field to_table fun(self: self, max_count?: integer): integer[]
+---@class LuaLoader.RDRAM.View : userdata
+---@field get_address   fun(self: self): integer
+---@field get_length    fun(self: self): integer
+---@field get_type      fun(self: self): LuaLoader.RDRAM.ScanType
+---@field read_value    fun(self: self, type: LuaLoader.RDRAM.ScanType, index: integer): number
+---@field to_string     fun(self: self): string
+---@field hash          fun(self: self, seed?: integer): integer
+---@field compress      fun(self: self): string?
+---@field write_to_file fun(self: self, file_path: string): (true?, string?, integer?)
+---@class LuaLoader.RDRAM.module
+---@field open fun(file_path: string, capacity?: integer, is_writable?: boolean): (LuaLoader.RDRAM?, string?, integer?)
+---@field decompress fun(data: string, length: integer): string
+local rdram_module = require("rdram")
+
+--------------------------------------------------------------------------------
+
+-- Snapshots and their codec, on data written by the test itself: a full
+-- snapshot and two deltas on top of it get written, reopened and compared
+-- against the memory they were taken of, and then broken in various ways.
+do
+	local page_size = 0x1000
+	local capacity = (17 * page_size) + 0x100 -- ending in a partial page
+	local base_name = os.tmpname()
+	local raw_path = base_name .. ".bin"
+	local full_path = base_name .. ".full.snap"
+	local delta_path = base_name .. ".delta.snap"
+	local delta2_path = base_name .. ".delta2.snap"
+	local broken_path = base_name .. ".broken.snap"
+
+	local function read_file(file_path)
+		local file <close> = assert(io.open(file_path, "rb"))
+		return assert(file:read("a"))
+	end
+
+	local function write_file(file_path, data)
+		local file <close> = assert(io.open(file_path, "wb"))
+		assert(file:write(data))
+	end
+
+	local function contents(instance)
+		return instance:view(0, instance:get_capacity()):to_string()
+	end
+
+	write_file(raw_path, string.rep("\0", capacity))
+	local memory = assert(rdram_module.open(raw_path, nil, true))
+
+	-- Page 1 stays zero, pages 2 and 3 are identical and compress well, page 4
+	-- does not compress at all and the partial page at the end is not empty.
+	local random = {}
+	local state = 12345
+	for i = 1, page_size do
+		state = (state * 1103515245 + 12345) % 0x80000000
+		random[i] = string.char((state >> 16) & 0xFF)
+	end
+	memory:fill(1 + (1 * page_size), page_size, "LuaLoader!")
+	memory:fill(1 + (2 * page_size), page_size, "LuaLoader!")
+	memory:write_bytes(1 + (3 * page_size), table.concat(random))
+	memory:fill(1 + (17 * page_size), 0x100, 0x5A)
+
+	assert(memory:write_snapshot(full_path))
+	local full = assert(rdram_module.open(full_path))
+	assert(full:get_capacity() == capacity)
+	assert(contents(full) == contents(memory))
+	-- Zero pages are left out and the repeated page is only stored once.
+	assert(#read_file(full_path) < (3 * page_size))
+
+	memory:write_value_u32(1 + (1 * page_size), 0xDEADBEEF)
+	memory:fill(1 + (5 * page_size), page_size, 0x11)
+	local delta_name = delta_path:match("[^/]*$")
+	local full_name = full_path:match("[^/]*$")
+	assert(memory:write_snapshot(delta_path, full, full_name))
+	local delta = assert(rdram_module.open(delta_path))
+	assert(contents(delta) == contents(memory))
+	-- Only the two changed pages are stored.
+	assert(#read_file(delta_path) < 0x400)
+
+	memory:fill(1, 0x10, 0x22)
+	assert(memory:write_snapshot(delta2_path, delta, delta_name))
+	local delta2 = assert(rdram_module.open(delta2_path))
+	assert(contents(delta2) == contents(memory))
+
+	-- The codec has to reject anything that does not decompress to exactly the
+	-- requested length.
+	local view = memory:view(1 * page_size, page_size)
+	local compressed = assert(view:compress())
+	assert(rdram_module.decompress(compressed, page_size) == view:to_string())
+	assert(not pcall(rdram_module.decompress, compressed:sub(1, -2), page_size))
+	assert(not pcall(rdram_module.decompress, compressed, page_size + 1))
+	assert(not pcall(rdram_module.decompress, "\255\255\255\255", page_size))
+
+	-- `magic`, `version`, `page_size`, `capacity`, `page_count`,
+	-- `entry_count` and `index_offset` of the `SnapshotHeader`.
+	local header_format = "=c8I4I4I8I8I8I8"
+	local full_data = read_file(full_path)
+	local index_offset = select(7, string.unpack(header_format, full_data))
+
+	write_file(broken_path, full_data:sub(1, -9))
+	assert(rdram_module.open(broken_path) == nil, "truncated page index")
+
+	-- The `kind` of the first `SnapshotPageEntry`.
+	local kind_offset = index_offset + 20
+	write_file(broken_path, full_data:sub(1, kind_offset) .. string.pack("=I4", 7) .. full_data:sub(kind_offset + 5))
+	assert(rdram_module.open(broken_path) == nil, "invalid page kind")
+
+	os.remove(broken_path)
+	assert(rdram_module.open(delta_path) ~= nil)
+	os.rename(full_path, broken_path)
+	assert(rdram_module.open(delta_path) == nil, "missing base")
+
+	-- A base with different contents than the one the delta was written on.
+	memory:fill(1 + (7 * page_size), page_size, 0x33)
+	assert(memory:write_snapshot(full_path))
+	assert(rdram_module.open(delta2_path) == nil, "mismatched base")
+
+	for _, file_path in ipairs({ base_name, raw_path, full_path, delta_path, delta2_path, broken_path }) do
+		os.remove(file_path)
+	end
+
+	print("\027[0;1;42m OK \027[0m snapshots")
+end
+
+--------------------------------------------------------------------------------
+
+local rdram = assert(rdram_module.open("./rdram-dump.bin"))
 
 --------------------------------------------------------------------------------
 
@@ -5,18 +5,18 @@
 
 #include "../mod_recomp.h"
 #include "./logging.h"
+#include "./swizzle.h"
 #include "./types.h"
 
-#define TRY_GET_ARRAY_ARGUMENT_IMPL_HELPER__(ITEM_TYPE, MEM_GETTER) { \
-	while (MEM_GETTER(arg_n64_ptr, length)) length++; \
+#define TRY_GET_ARRAY_ARGUMENT_IMPL_HELPER__(ITEM_TYPE, RAW_ITEM_TYPE, MEM_LOADER, MEM_READER) { \
+	const RecompGPR arg_address = arg_n64_ptr & 0x7FFFFFFFULL; \
+	while (MEM_LOADER(rdram, arg_address + (length * sizeof(ITEM_TYPE)))) length++; \
 	ITEM_TYPE *array = (ITEM_TYPE *)memory_allocator((length + 1) * sizeof(ITEM_TYPE)); \
 	if (array == NULL) { \
 		LOG("Failed to allocate memory for destination array!"); \
 		return 0; \
 	} \
-	for (size_t i = 0; i < length; i++) { \
-		array[i] = (ITEM_TYPE)MEM_GETTER(arg_n64_ptr, i); \
-	} \
+	MEM_READER((RAW_ITEM_TYPE *)array, rdram, arg_address, length); \
 	array[length] = 0; \
 	*((ITEM_TYPE **)destination) = array; \
 	break; \
@@ -81,8 +81,10 @@ static size_t try_get_array_u8(
 		alloc_fn = malloc;
 	}
 
+	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
+
 	if (length == 0) {
-		while (MEM_BU(array, length)) {
+		while (rdram_load_u8(rdram, array_corrected + length)) {
 			length++;
 		}
 	}
@@ -94,11 +96,9 @@ static size_t try_get_array_u8(
 		return 0;
 	}
 
-	for (size_t i = 0; i < length; i++) {
-		array_native[i] = (u8)MEM_BU(array, i);
-	}
-
+	rdram_read_bytes(array_native, rdram, array_corrected, length);
 	array_native[length] = 0;
+	*destination = array_native;
 
 	return allocated_bytes;
 }
@@ -144,9 +144,9 @@ static size_t try_get_array_argument(
 
 	size_t length = 0;
 	switch (item_type_size) {
-		case 1: TRY_GET_ARRAY_ARGUMENT_IMPL_HELPER__(s8,  MEM_B);
-		case 2: TRY_GET_ARRAY_ARGUMENT_IMPL_HELPER__(s16, MEM_H);
-		case 4: TRY_GET_ARRAY_ARGUMENT_IMPL_HELPER__(s32, MEM_W);
+		case 1: TRY_GET_ARRAY_ARGUMENT_IMPL_HELPER__(s8,  u8,  rdram_load_u8,  rdram_read_bytes);
+		case 2: TRY_GET_ARRAY_ARGUMENT_IMPL_HELPER__(s16, u16, rdram_load_u16, rdram_read_u16_array);
+		case 4: TRY_GET_ARRAY_ARGUMENT_IMPL_HELPER__(s32, u32, rdram_load_u32, rdram_read_u32_array);
 		default: {
 			LOG("Invalid value of argument #7 `item_type_size`! (expected one of (1, 2, 4), got: %"PRIu8")", item_type_size);
 			LOG("    -> arg_n64_ptr = 0x%016"PRIx64, arg_n64_ptr);
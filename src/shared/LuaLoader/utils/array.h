@@ -3,6 +3,7 @@
 #ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__ARRAY_H_
 #define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__ARRAY_H_ 1
 
+#include <assert.h>
 #include <inttypes.h>
 #include <math.h>
 #include <stdbool.h>
@@ -11,6 +12,7 @@
 #include <stdlib.h>
 
 #include "../mod_recomp.h"
+#include "./swizzle.h"
 #include "./types.h"
 
 static size_t get_array_char(
@@ -21,15 +23,17 @@ static size_t get_array_char(
 	size_t length,
 	char **restrict const destination
 ) {
-	if (!(rdram || ctx || array || destination)) return 0ULL;
-	if (alloc_fn != NULL) alloc_fn = malloc;
+	(void)ctx;
+	if ((rdram == NULL) || (array == 0) || (destination == NULL)) return 0ULL;
+	if (alloc_fn == NULL) alloc_fn = malloc;
 
 	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
 
 	if (length == 0ULL) {
-		while (((u8 *)rdram)[(array_corrected + length) ^ 3ULL]) {
-			length++;
-		}
+		// The search must not run off the end of the memory the recomp
+		// actually reserved, even for a string that is missing its NUL.
+		if (array_corrected >= RDRAM_LENGTH) return 0ULL;
+		length = rdram_string_length((const u8 *)rdram, array_corrected, (size_t)(RDRAM_LENGTH - array_corrected));
 	}
 
 	size_t allocated_bytes = (length + 1ULL) * sizeof(char);
@@ -38,238 +42,51 @@ static size_t get_array_char(
 	*destination = result;
 	result[length] = 0;
 
-	for (size_t i = 0ULL; i < length; i++) {
-		size_t index = (array_corrected + i) ^ 3ULL;
-		assert((index & 0xFFFFFFFF80000000ULL) == 0ULL);
-		result[i] = ((const char *)rdram)[index];
-	}
+	assert(((array_corrected + length) & 0xFFFFFFFF80000000ULL) == 0ULL);
+	rdram_read_bytes((u8 *)result, (const u8 *)rdram, array_corrected, length);
 
 	return allocated_bytes;
 }
 
-static size_t get_array_s8(
-	const void *restrict const rdram,
-	const RecompContext *restrict const ctx,
-	void *(*alloc_fn)(size_t size),
-	const RecompGPR array,
-	const size_t length,
-	s8 **restrict const destination
-) {
-	if (!(rdram || ctx || array || length || destination)) return 0ULL;
-	if (alloc_fn != NULL) alloc_fn = malloc;
-
-	size_t allocated_bytes = (length + 1ULL) * sizeof(s8);
-	s8 *result = (s8 *)alloc_fn(allocated_bytes);
-	assert(result != NULL);
-	*destination = result;
-	result[length] = 0;
-
-	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
-	for (size_t i = 0ULL; i < length; i++) {
-		size_t index = (array_corrected + i) ^ 3ULL;
-		assert((index & 0xFFFFFFFF80000000ULL) == 0ULL);
-		result[i] = ((const s8 *)rdram)[index];
-	}
-
-	return allocated_bytes;
+/**
+ * All `get_array_*` variants below copy `length` items from N64 memory into a
+ * freshly allocated, zero-terminated host array, converting each item into host
+ * byte order through the kernels from `utils/swizzle.h`.
+ */
+#define IMPL_GET_ARRAY(TYPENAME, RAW_TYPENAME, READER) \
+static size_t get_array_##TYPENAME( \
+	const void *restrict const rdram, \
+	const RecompContext *restrict const ctx, \
+	void *(*alloc_fn)(size_t size), \
+	const RecompGPR array, \
+	const size_t length, \
+	TYPENAME **restrict const destination \
+) { \
+	(void)ctx; \
+	if ((rdram == NULL) || (array == 0) || (destination == NULL)) return 0ULL; \
+	if (alloc_fn == NULL) alloc_fn = malloc; \
+\
+	size_t allocated_bytes = (length + 1ULL) * sizeof(TYPENAME); \
+	TYPENAME *result = (TYPENAME *)alloc_fn(allocated_bytes); \
+	assert(result != NULL); \
+	*destination = result; \
+	result[length] = 0; \
+\
+	const RecompGPR array_corrected = array & 0x7FFFFFFFULL; \
+	assert(((array_corrected + (length * sizeof(TYPENAME))) & 0xFFFFFFFF80000000ULL) == 0ULL); \
+	READER((RAW_TYPENAME *)result, (const u8 *)rdram, array_corrected, length); \
+\
+	return allocated_bytes; \
 }
 
-static size_t get_array_u8(
-	const void *restrict const rdram,
-	const RecompContext *restrict const ctx,
-	void *(*alloc_fn)(size_t size),
-	const RecompGPR array,
-	const size_t length,
-	u8 **restrict const destination
-) {
-	if (!(rdram || ctx || array || length || destination)) return 0ULL;
-	if (alloc_fn != NULL) alloc_fn = malloc;
-
-	size_t allocated_bytes = (length + 1ULL) * sizeof(u8);
-	u8 *result = (u8 *)alloc_fn(allocated_bytes);
-	assert(result != NULL);
-	*destination = result;
-	result[length] = 0;
-
-	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
-	for (size_t i = 0ULL; i < length; i++) {
-		size_t index = (array_corrected + i) ^ 3ULL;
-		assert((index & 0xFFFFFFFF80000000ULL) == 0ULL);
-		result[i] = ((const u8 *)rdram)[index];
-	}
-
-	return allocated_bytes;
-}
-
-static size_t get_array_s16(
-	const void *restrict const rdram,
-	const RecompContext *restrict const ctx,
-	void *(*alloc_fn)(size_t size),
-	const RecompGPR array,
-	const size_t length,
-	s16 **restrict const destination
-) {
-	if (!(rdram || ctx || array || length || destination)) return 0ULL;
-	if (alloc_fn != NULL) alloc_fn = malloc;
-
-	size_t allocated_bytes = (length + 1ULL) * sizeof(s16);
-	s16 *result = (s16 *)alloc_fn(allocated_bytes);
-	assert(result != NULL);
-	*destination = result;
-	result[length] = 0;
-
-	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
-	for (size_t i = 0ULL; i < length; i++) {
-		size_t index = (array_corrected + i) ^ 2ULL;
-		assert((index & 0xFFFFFFFF80000000ULL) == 0ULL);
-		result[i] = ((const s16 *)rdram)[index];
-	}
-
-	return allocated_bytes;
-}
-
-static size_t get_array_u16(
-	const void *restrict const rdram,
-	const RecompContext *restrict const ctx,
-	void *(*alloc_fn)(size_t size),
-	const RecompGPR array,
-	const size_t length,
-	u16 **restrict const destination
-) {
-	if (!(rdram || ctx || array || length || destination)) return 0ULL;
-	if (alloc_fn != NULL) alloc_fn = malloc;
-
-	size_t allocated_bytes = (length + 1ULL) * sizeof(u16);
-	u16 *result = (u16 *)alloc_fn(allocated_bytes);
-	assert(result != NULL);
-	*destination = result;
-	result[length] = 0;
-
-	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
-	for (size_t i = 0ULL; i < length; i++) {
-		size_t index = (array_corrected + i) ^ 2ULL;
-		assert((index & 0xFFFFFFFF80000000ULL) == 0ULL);
-		result[i] = ((const u16 *)rdram)[index];
-	}
-
-	return allocated_bytes;
-}
-
-static size_t get_array_s32(
-	const void *restrict const rdram,
-	const RecompContext *restrict const ctx,
-	void *(*alloc_fn)(size_t size),
-	const RecompGPR array,
-	const size_t length,
-	s32 **restrict const destination
-) {
-	if (!(rdram || ctx || array || length || destination)) return 0ULL;
-	if (alloc_fn != NULL) alloc_fn = malloc;
-
-	size_t allocated_bytes = (length + 1ULL) * sizeof(s32);
-	s32 *result = (s32 *)alloc_fn(allocated_bytes);
-	assert(result != NULL);
-	*destination = result;
-	result[length] = 0;
-
-	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
-	for (size_t i = 0ULL; i < length; i++) {
-		size_t index = array_corrected + i;
-		assert((index & 0xFFFFFFFF80000000ULL) == 0ULL);
-		result[i] = ((const s32 *)rdram)[index];
-	}
-
-	return allocated_bytes;
-}
-
-static size_t get_array_u32(
-	const void *restrict const rdram,
-	const RecompContext *restrict const ctx,
-	void *(*alloc_fn)(size_t size),
-	const RecompGPR array,
-	const size_t length,
-	u32 **restrict const destination
-) {
-	if (!(rdram || ctx || array || length || destination)) return 0ULL;
-	if (alloc_fn != NULL) alloc_fn = malloc;
-
-	size_t allocated_bytes = (length + 1ULL) * sizeof(u32);
-	u32 *result = (u32 *)alloc_fn(allocated_bytes);
-	assert(result != NULL);
-	*destination = result;
-	result[length] = 0;
-
-	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
-	for (size_t i = 0ULL; i < length; i++) {
-		size_t index = array_corrected + i;
-		assert((index & 0xFFFFFFFF80000000ULL) == 0ULL);
-		result[i] = ((const u32 *)rdram)[index];
-	}
-
-	return allocated_bytes;
-}
-
-static size_t get_array_s64(
-	const void *restrict const rdram,
-	const RecompContext *restrict const ctx,
-	void *(*alloc_fn)(size_t size),
-	const RecompGPR array,
-	const size_t length,
-	s64 **restrict const destination
-) {
-	if (!(rdram || ctx || array || length || destination)) return 0ULL;
-	if (alloc_fn != NULL) alloc_fn = malloc;
-
-	size_t allocated_bytes = (length + 1ULL) * sizeof(s64);
-	u64 *result = (u64 *)alloc_fn(allocated_bytes);
-	assert(result != NULL);
-	*destination = (s64 *)result;
-	result[length] = 0;
-
-	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
-	const u32 *rdram_u32 = (const u32 *)rdram;
-	for (size_t i = 0ULL; i < length; i++) {
-		size_t high_index = array_corrected + i;
-
-		u64 high = (u64)(rdram_u32[high_index]);
-		u64 low  = (u64)(rdram_u32[high_index + 4ULL]);
-
-		result[i] = (low << 0ULL) | (high << 32ULL);
-	}
-
-	return allocated_bytes;
-}
-
-static size_t get_array_u64(
-	const void *restrict const rdram,
-	const RecompContext *restrict const ctx,
-	void *(*alloc_fn)(size_t size),
-	const RecompGPR array,
-	const size_t length,
-	u64 **restrict const destination
-) {
-	if (!(rdram || ctx || array || length || destination)) return 0ULL;
-	if (alloc_fn != NULL) alloc_fn = malloc;
-
-	size_t allocated_bytes = (length + 1ULL) * sizeof(u64);
-	u64 *result = (u64 *)alloc_fn(allocated_bytes);
-	assert(result != NULL);
-	*destination = result;
-	result[length] = 0;
-
-	const RecompGPR array_corrected = array & 0x7FFFFFFFULL;
-	const u32 *rdram_u32 = (const u32 *)rdram;
-	for (size_t i = 0ULL; i < length; i++) {
-		size_t high_index = array_corrected + i;
-
-		u64 high = (u64)(rdram_u32[high_index]);
-		u64 low  = (u64)(rdram_u32[high_index + 4ULL]);
-
-		result[i] = (low << 0ULL) | (high << 32ULL);
-	}
-
-	return allocated_bytes;
-}
+IMPL_GET_ARRAY(s8,  u8,  rdram_read_bytes)
+IMPL_GET_ARRAY(u8,  u8,  rdram_read_bytes)
+IMPL_GET_ARRAY(s16, u16, rdram_read_u16_array)
+IMPL_GET_ARRAY(u16, u16, rdram_read_u16_array)
+IMPL_GET_ARRAY(s32, u32, rdram_read_u32_array)
+IMPL_GET_ARRAY(u32, u32, rdram_read_u32_array)
+IMPL_GET_ARRAY(s64, u64, rdram_read_u64_array)
+IMPL_GET_ARRAY(u64, u64, rdram_read_u64_array)
 
 #define get_array(array, length, destination) \
 (_Generic((destination), \
@@ -0,0 +1,402 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__BYTECODE_CACHE_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__BYTECODE_CACHE_H_ 1
+
+/**
+ * Caches compiled Lua chunks on disk, next to the scripts they were compiled
+ * from, so that scripts only get lexed and parsed again after they changed.
+ *
+ * A cache file is a `BytecodeCacheHeader` followed by the output of
+ * `lua_dump()`. It is only used if the path, modification time, size and
+ * content hash of the script all still match its key, and if the bytecode
+ * itself is intact; otherwise the script is loaded from source (and the cache
+ * rewritten). Failing to write a cache file is not an error, the script just
+ * gets parsed again next time.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "../lua/src/lua.h"
+#include "../lua/src/lualib.h"
+#include "../lua/src/lauxlib.h"
+
+#include "./hash.h"
+#include "./mem.h"
+#include "./types.h"
+
+#define BYTECODE_CACHE_SUFFIX ".cache"
+
+// Bump this whenever the layout of `BytecodeCacheHeader` changes.
+#define BYTECODE_CACHE_VERSION 1U
+
+static const char bytecode_cache_magic[8] = { 'L', 'u', 'a', 'L', 'B', 'C', 'C', '\0' };
+
+typedef struct BytecodeCacheKey {
+	u64 path_hash;
+	u64 mtime;
+	u64 size;
+	u64 content_hash;
+} BytecodeCacheKey;
+
+typedef struct BytecodeCacheHeader {
+	char magic[8];
+	u32 version;
+	u32 lua_version; // `LUA_VERSION_NUM`
+	BytecodeCacheKey key;
+	u64 bytecode_size;
+	u64 bytecode_hash;
+} BytecodeCacheHeader;
+
+/**
+ * @brief Read all of `file` into a new buffer allocated with `malloc()`.
+ * @return `NULL` on error.
+ */
+static inline u8 *bytecode_cache_read_all(FILE *file, size_t *restrict const out_size) {
+	size_t capacity = 0x4000ULL;
+	size_t size = 0ULL;
+	u8 *data = (u8 *)malloc(capacity);
+
+	while (data != NULL) {
+		size += fread(data + size, sizeof(u8), capacity - size, file);
+		if (size < capacity) {
+			break;
+		}
+
+		capacity *= 2ULL;
+		u8 *new_data = (u8 *)realloc(data, capacity);
+		if (new_data == NULL) {
+			free(data);
+		}
+		data = new_data;
+	}
+
+	if ((data != NULL) && ferror(file)) {
+		free(data);
+		data = NULL;
+	}
+
+	*out_size = size;
+	return data;
+}
+
+/**
+ * @brief Load the bytecode stored in `cache_path` if it was compiled from a
+ *        script matching `key`.
+ * @return `NULL` if there is no usable cache entry.
+ */
+static inline u8 *bytecode_cache_read(
+		const char *restrict const cache_path,
+		const BytecodeCacheKey *restrict const key,
+		size_t *restrict const out_size
+) {
+	FILE *file = fopen(cache_path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	BytecodeCacheHeader header;
+	const bool is_valid = (
+		(fread(&header, sizeof(header), 1, file) == 1) &&
+		(memcmp(header.magic, bytecode_cache_magic, sizeof(header.magic)) == 0) &&
+		(header.version == BYTECODE_CACHE_VERSION) &&
+		(header.lua_version == (u32)LUA_VERSION_NUM) &&
+		(memcmp(&(header.key), key, sizeof(*key)) == 0)
+	);
+
+	u8 *bytecode = NULL;
+	size_t size = 0ULL;
+	if (is_valid) {
+		bytecode = bytecode_cache_read_all(file, &size);
+	}
+	fclose(file);
+
+	if ((bytecode != NULL) && (
+		(size != header.bytecode_size) ||
+		(hash_bytes(bytecode, size, 0ULL) != header.bytecode_hash)
+	)) {
+		free(bytecode);
+		bytecode = NULL;
+	}
+
+	*out_size = size;
+	return bytecode;
+}
+
+/**
+ * @brief Replace the cache entry at `cache_path`. A temporary file is written
+ *        first, so that a crash cannot leave a truncated entry behind.
+ */
+static inline bool bytecode_cache_write(
+		const char *restrict const cache_path,
+		const BytecodeCacheKey *restrict const key,
+		const u8 *restrict const bytecode,
+		const size_t size
+) {
+	const size_t cache_path_length = strlen(cache_path);
+	AUTO_FREE char *temp_path = (char *)malloc(cache_path_length + sizeof(".tmp"));
+	if (temp_path == NULL) {
+		return false;
+	}
+	memcpy(temp_path, cache_path, cache_path_length);
+	memcpy(temp_path + cache_path_length, ".tmp", sizeof(".tmp"));
+
+	FILE *file = fopen(temp_path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	BytecodeCacheHeader header = {
+		.version = BYTECODE_CACHE_VERSION,
+		.lua_version = (u32)LUA_VERSION_NUM,
+		.key = *key,
+		.bytecode_size = (u64)size,
+		.bytecode_hash = hash_bytes(bytecode, size, 0ULL),
+	};
+	memcpy(header.magic, bytecode_cache_magic, sizeof(header.magic));
+
+	bool success = (
+		(fwrite(&header, sizeof(header), 1, file) == 1) &&
+		(fwrite(bytecode, sizeof(u8), size, file) == size)
+	);
+	success = (fclose(file) == 0) && success;
+
+	// `rename()` does not replace existing files on Windows.
+	if (success) {
+		remove(cache_path);
+		success = rename(temp_path, cache_path) == 0;
+	}
+
+	if (!success) {
+		remove(temp_path);
+	}
+
+	return success;
+}
+
+typedef struct BytecodeCacheDumpBuffer {
+	u8 *data;
+	size_t size;
+	size_t capacity;
+} BytecodeCacheDumpBuffer;
+
+static inline int bytecode_cache_dump_writer(lua_State *L, const void *chunk, size_t chunk_size, void *user_data) {
+	(void)L;
+
+	BytecodeCacheDumpBuffer *buffer = (BytecodeCacheDumpBuffer *)user_data;
+
+	if ((buffer->size + chunk_size) > buffer->capacity) {
+		size_t capacity = (buffer->capacity == 0ULL) ? 0x4000ULL : buffer->capacity;
+		while ((buffer->size + chunk_size) > capacity) {
+			capacity *= 2ULL;
+		}
+
+		u8 *data = (u8 *)realloc(buffer->data, capacity);
+		if (data == NULL) {
+			return 1;
+		}
+
+		buffer->data = data;
+		buffer->capacity = capacity;
+	}
+
+	memcpy(buffer->data + buffer->size, chunk, chunk_size);
+	buffer->size += chunk_size;
+
+	return 0;
+}
+
+static inline BytecodeCacheKey bytecode_cache_make_key(const char *file_path, const u8 *source, const size_t source_size) {
+	struct stat file_info;
+	const u64 mtime = (stat(file_path, &file_info) == 0) ? (u64)(file_info.st_mtime) : 0ULL;
+
+	return (BytecodeCacheKey){
+		.path_hash = hash_bytes((const u8 *)file_path, strlen(file_path), 0ULL),
+		.mtime = mtime,
+		.size = (u64)source_size,
+		.content_hash = hash_bytes(source, source_size, 0ULL),
+	};
+}
+
+/**
+ * @return The path of the cache entry for `file_path`, allocated with
+ *         `malloc()`, or `NULL` if out of memory.
+ */
+static inline char *bytecode_cache_make_path(const char *file_path) {
+	const size_t file_path_length = strlen(file_path);
+	char *cache_path = (char *)malloc(file_path_length + sizeof(BYTECODE_CACHE_SUFFIX));
+	if (cache_path != NULL) {
+		memcpy(cache_path, file_path, file_path_length);
+		memcpy(cache_path + file_path_length, BYTECODE_CACHE_SUFFIX, sizeof(BYTECODE_CACHE_SUFFIX));
+	}
+
+	return cache_path;
+}
+
+/**
+ * @brief A drop-in replacement for `luaL_loadfilex(L, file_path, "t")` that
+ *        goes through the cache.
+ *
+ * If `out_bytecode` is not `NULL`, the bytecode of the loaded chunk is handed
+ * back through it as well (allocated with `malloc()`): the cache entry it was
+ * loaded from, or else the output of the same `lua_dump()` that refreshed the
+ * cache, so that callers never have to dump the chunk a second time.
+ *
+ * @return The same status codes as `luaL_loadfilex()`, with either the loaded
+ *         chunk or an error message pushed onto the stack.
+ */
+static inline int bytecode_cache_load_file_ex(
+		lua_State *L,
+		const char *file_path,
+		BytecodeCacheDumpBuffer *restrict const out_bytecode
+) {
+	const char *chunk_name = lua_pushfstring(L, "@%s", file_path);
+	const int chunk_name_index = lua_gettop(L);
+
+	FILE *file = fopen(file_path, "rb");
+	if (file == NULL) {
+		lua_pushfstring(L, "cannot open %s", file_path);
+		lua_remove(L, chunk_name_index);
+		return LUA_ERRFILE;
+	}
+
+	size_t source_size = 0ULL;
+	AUTO_FREE u8 *source = bytecode_cache_read_all(file, &source_size);
+	fclose(file);
+	if (source == NULL) {
+		lua_pushfstring(L, "cannot read %s", file_path);
+		lua_remove(L, chunk_name_index);
+		return LUA_ERRFILE;
+	}
+
+	const BytecodeCacheKey key = bytecode_cache_make_key(file_path, source, source_size);
+
+	AUTO_FREE char *cache_path = bytecode_cache_make_path(file_path);
+	if (cache_path != NULL) {
+		size_t bytecode_size = 0ULL;
+		u8 *bytecode = bytecode_cache_read(cache_path, &key, &bytecode_size);
+		if (bytecode != NULL) {
+			if (luaL_loadbufferx(L, (const char *)bytecode, bytecode_size, chunk_name, "b") == LUA_OK) {
+				lua_remove(L, chunk_name_index);
+				if (out_bytecode != NULL) {
+					*out_bytecode = (BytecodeCacheDumpBuffer){
+						.data = bytecode,
+						.size = bytecode_size,
+						.capacity = bytecode_size,
+					};
+				} else {
+					free(bytecode);
+				}
+				return LUA_OK;
+			}
+
+			free(bytecode);
+			lua_pop(L, 1);
+		}
+	}
+
+	// Skip a UTF-8 BOM and a first line starting with `#` (e.g. a shebang),
+	// like `luaL_loadfilex()` does. The newline is kept so that line numbers
+	// stay the same.
+	size_t offset = 0ULL;
+	if ((source_size >= 3ULL) && (memcmp(source, "\xEF\xBB\xBF", 3) == 0)) {
+		offset = 3ULL;
+	}
+	if ((offset < source_size) && (source[offset] == '#')) {
+		while ((offset < source_size) && (source[offset] != '\n')) {
+			offset++;
+		}
+	}
+
+	const int status = luaL_loadbufferx(L, (const char *)source + offset, source_size - offset, chunk_name, "t");
+	lua_remove(L, chunk_name_index);
+	if ((status != LUA_OK) || ((cache_path == NULL) && (out_bytecode == NULL))) {
+		return status;
+	}
+
+	BytecodeCacheDumpBuffer dump = { 0 };
+	if (lua_dump(L, bytecode_cache_dump_writer, &dump, 0) != 0) {
+		free(dump.data);
+		if (out_bytecode == NULL) {
+			return LUA_OK;
+		}
+
+		lua_pop(L, 1);
+		lua_pushliteral(L, "not enough memory to dump the compiled chunk");
+		return LUA_ERRMEM;
+	}
+
+	if (cache_path != NULL) {
+		bytecode_cache_write(cache_path, &key, dump.data, dump.size);
+	}
+
+	if (out_bytecode != NULL) {
+		*out_bytecode = dump;
+	} else {
+		free(dump.data);
+	}
+
+	return LUA_OK;
+}
+
+/**
+ * @brief `bytecode_cache_load_file_ex()` without handing back the bytecode.
+ */
+static inline int bytecode_cache_load_file(lua_State *L, const char *file_path) {
+	return bytecode_cache_load_file_ex(L, file_path, NULL);
+}
+
+/**
+ * @brief Takes the place of the `package.searchers` entry for Lua files, so
+ *        that modules loaded with `require()` get cached as well.
+ */
+static inline int bytecode_cache_searcher(lua_State *L) {
+	const char *name = luaL_checkstring(L, 1);
+
+	lua_getglobal(L, LUA_LOADLIBNAME);
+	lua_getfield(L, -1, "searchpath");
+	lua_pushvalue(L, 1);
+	lua_getfield(L, -3, "path");
+	lua_call(L, 2, 2);
+
+	if (lua_isnil(L, -2)) {
+		// Not found; the second value explains where it was looked for.
+		return 1;
+	}
+
+	const char *file_path = lua_tostring(L, -2);
+	if (bytecode_cache_load_file(L, file_path) != LUA_OK) {
+		return luaL_error(
+			L,
+			"error loading module '%s' from file '%s':\n\t%s",
+			name,
+			file_path,
+			lua_tostring(L, -1)
+		);
+	}
+
+	// Like the standard searcher, pass the file path on to the module.
+	lua_pushvalue(L, -3);
+
+	return 2;
+}
+
+/**
+ * @brief Make `require()` use `bytecode_cache_searcher()`. `L` must have the
+ *        `package` library loaded.
+ */
+static inline void bytecode_cache_install_searcher(lua_State *L) {
+	lua_getglobal(L, LUA_LOADLIBNAME);
+	if (lua_getfield(L, -1, "searchers") == LUA_TTABLE) {
+		lua_pushcfunction(L, bytecode_cache_searcher);
+		lua_rawseti(L, -2, 2);
+	}
+	lua_pop(L, 2);
+}
+
+#endif
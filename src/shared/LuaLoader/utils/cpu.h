@@ -0,0 +1,54 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__CPU_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__CPU_H_ 1
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "./types.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CPU_ARCH_X86 1
+#else
+#define CPU_ARCH_X86 0
+#endif
+
+/**
+ * @brief Instruction set extensions that the kernels in `utils/` know how to
+ *        make use of.
+ */
+typedef enum CPUFeatures {
+	CPUFeatures_None  = 0U,
+	CPUFeatures_SSE2  = 1U << 0,
+	CPUFeatures_SSSE3 = 1U << 1,
+	CPUFeatures_AVX2  = 1U << 2,
+} CPUFeatures;
+
+/**
+ * @brief Query the instruction set extensions supported by the host CPU.
+ *
+ * Setting the environment variable `LUA_LOADER_DISABLE_SIMD` to any non-empty
+ * value forces the scalar fallbacks to be used, which is mostly useful for
+ * testing them.
+ */
+static inline CPUFeatures cpu_get_features(void) {
+	const char *disable_simd = getenv("LUA_LOADER_DISABLE_SIMD");
+	if ((disable_simd != NULL) && (disable_simd[0] != '\0')) {
+		return CPUFeatures_None;
+	}
+
+	CPUFeatures features = CPUFeatures_None;
+
+#if CPU_ARCH_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2"))  features |= CPUFeatures_SSE2;
+	if (__builtin_cpu_supports("ssse3")) features |= CPUFeatures_SSSE3;
+	if (__builtin_cpu_supports("avx2"))  features |= CPUFeatures_AVX2;
+#endif
+
+	return features;
+}
+
+#endif
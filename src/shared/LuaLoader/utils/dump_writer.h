@@ -0,0 +1,249 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__DUMP_WRITER_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__DUMP_WRITER_H_ 1
+
+/**
+ * Writes memory dumps to disk on a background thread.
+ *
+ * The game thread only copies the data into one of `DUMP_WRITER_BUFFER_COUNT`
+ * staging buffers and hands it off, so a slow disk never stalls a frame. The
+ * buffers are kept around and reused, so after the first few dumps no more
+ * memory gets allocated either. Every dump is identified by a handle that can
+ * be polled with `dump_writer_poll()`.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include "./types.h"
+
+#define DUMP_WRITER_BUFFER_COUNT 2
+
+// How many finished dumps can still be polled for their result.
+#define DUMP_WRITER_RESULT_HISTORY 64
+
+typedef enum DumpStatus {
+	DumpStatus_Unknown = -2, // never submitted, or too long ago to remember
+	DumpStatus_Failed  = -1,
+	DumpStatus_Pending =  0,
+	DumpStatus_Done    =  1,
+} DumpStatus;
+
+typedef struct DumpWriterBuffer {
+	u8 *data;
+	size_t capacity;
+	size_t size;
+	char *file_path;
+	u32 handle;
+	bool is_queued; // while set, the buffer belongs to the writer thread
+} DumpWriterBuffer;
+
+typedef struct DumpWriter {
+	mtx_t mutex;
+	cnd_t has_work;
+	thrd_t thread;
+	bool is_started;
+	bool should_stop;
+	DumpWriterBuffer buffers[DUMP_WRITER_BUFFER_COUNT];
+	u32 last_handle;
+	struct {
+		u32 handle;
+		DumpStatus status;
+	} results[DUMP_WRITER_RESULT_HISTORY];
+} DumpWriter;
+
+static inline void dump_writer_set_result(DumpWriter *restrict const writer, const u32 handle, const DumpStatus status) {
+	writer->results[handle % DUMP_WRITER_RESULT_HISTORY].handle = handle;
+	writer->results[handle % DUMP_WRITER_RESULT_HISTORY].status = status;
+}
+
+static inline bool dump_writer_write_file(const DumpWriterBuffer *restrict const buffer) {
+	FILE *const file = fopen(buffer->file_path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	const bool success = fwrite(buffer->data, sizeof(u8), buffer->size, file) == buffer->size;
+
+	return (fclose(file) == 0) && success;
+}
+
+static inline int dump_writer_thread_main(void *arg) {
+	DumpWriter *writer = (DumpWriter *)arg;
+
+	mtx_lock(&(writer->mutex));
+
+	while (true) {
+		// Dumps are written in the order they were submitted in.
+		DumpWriterBuffer *buffer = NULL;
+		for (size_t i = 0; i < DUMP_WRITER_BUFFER_COUNT; i++) {
+			DumpWriterBuffer *candidate = &(writer->buffers[i]);
+			if (candidate->is_queued && ((buffer == NULL) || (candidate->handle < buffer->handle))) {
+				buffer = candidate;
+			}
+		}
+
+		if (buffer == NULL) {
+			if (writer->should_stop) {
+				break;
+			}
+
+			cnd_wait(&(writer->has_work), &(writer->mutex));
+			continue;
+		}
+
+		mtx_unlock(&(writer->mutex));
+		const bool success = dump_writer_write_file(buffer);
+		mtx_lock(&(writer->mutex));
+
+		dump_writer_set_result(writer, buffer->handle, success ? DumpStatus_Done : DumpStatus_Failed);
+		free(buffer->file_path);
+		buffer->file_path = NULL;
+		buffer->is_queued = false;
+	}
+
+	mtx_unlock(&(writer->mutex));
+
+	return 0;
+}
+
+static inline bool dump_writer_start(DumpWriter *restrict const writer) {
+	if (writer->is_started) {
+		return true;
+	}
+
+	if (mtx_init(&(writer->mutex), mtx_plain) != thrd_success) {
+		return false;
+	}
+
+	if (cnd_init(&(writer->has_work)) != thrd_success) {
+		mtx_destroy(&(writer->mutex));
+		return false;
+	}
+
+	writer->should_stop = false;
+	if (thrd_create(&(writer->thread), dump_writer_thread_main, writer) != thrd_success) {
+		cnd_destroy(&(writer->has_work));
+		mtx_destroy(&(writer->mutex));
+		return false;
+	}
+
+	writer->is_started = true;
+
+	return true;
+}
+
+/**
+ * @brief Finish writing all queued dumps, then stop the writer thread and free
+ *        the staging buffers.
+ */
+static inline void dump_writer_stop(DumpWriter *restrict const writer) {
+	if (!writer->is_started) {
+		return;
+	}
+
+	mtx_lock(&(writer->mutex));
+	writer->should_stop = true;
+	cnd_signal(&(writer->has_work));
+	mtx_unlock(&(writer->mutex));
+
+	thrd_join(writer->thread, NULL);
+	cnd_destroy(&(writer->has_work));
+	mtx_destroy(&(writer->mutex));
+
+	for (size_t i = 0; i < DUMP_WRITER_BUFFER_COUNT; i++) {
+		free(writer->buffers[i].data);
+		writer->buffers[i] = (DumpWriterBuffer){ 0 };
+	}
+
+	writer->is_started = false;
+}
+
+/**
+ * @brief Copy `size` bytes from `data` into a staging buffer and queue them to
+ *        be written to `file_path`. Returns as soon as the copy is done.
+ * @return A handle for `dump_writer_poll()`, or `0` if the dump could not be
+ *         queued (e.g. because all staging buffers are still being written).
+ */
+static inline u32 dump_writer_submit(
+		DumpWriter *restrict const writer,
+		const char *restrict const file_path,
+		const u8 *restrict const data,
+		const size_t size
+) {
+	if (!dump_writer_start(writer)) {
+		return 0;
+	}
+
+	DumpWriterBuffer *buffer = NULL;
+
+	mtx_lock(&(writer->mutex));
+	for (size_t i = 0; i < DUMP_WRITER_BUFFER_COUNT; i++) {
+		if (!writer->buffers[i].is_queued) {
+			buffer = &(writer->buffers[i]);
+			break;
+		}
+	}
+	mtx_unlock(&(writer->mutex));
+
+	if (buffer == NULL) {
+		return 0;
+	}
+
+	// The writer thread does not touch buffers that are not queued, so no
+	// lock is needed while filling this one.
+	if (buffer->capacity < size) {
+		u8 *new_data = (u8 *)realloc(buffer->data, size);
+		if (new_data == NULL) {
+			return 0;
+		}
+
+		buffer->data = new_data;
+		buffer->capacity = size;
+	}
+
+	buffer->file_path = strdup(file_path);
+	if (buffer->file_path == NULL) {
+		return 0;
+	}
+
+	memcpy(buffer->data, data, size);
+	buffer->size = size;
+
+	mtx_lock(&(writer->mutex));
+	writer->last_handle++;
+	if (writer->last_handle == 0) {
+		writer->last_handle++;
+	}
+
+	const u32 handle = writer->last_handle;
+	buffer->handle = handle;
+	buffer->is_queued = true;
+	dump_writer_set_result(writer, handle, DumpStatus_Pending);
+	cnd_signal(&(writer->has_work));
+	mtx_unlock(&(writer->mutex));
+
+	return handle;
+}
+
+static inline DumpStatus dump_writer_poll(DumpWriter *restrict const writer, const u32 handle) {
+	if (!writer->is_started || (handle == 0)) {
+		return DumpStatus_Unknown;
+	}
+
+	mtx_lock(&(writer->mutex));
+	DumpStatus status = DumpStatus_Unknown;
+	if (writer->results[handle % DUMP_WRITER_RESULT_HISTORY].handle == handle) {
+		status = writer->results[handle % DUMP_WRITER_RESULT_HISTORY].status;
+	}
+	mtx_unlock(&(writer->mutex));
+
+	return status;
+}
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__HASH_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__HASH_H_ 1
+
+#include <stddef.h>
+#include <string.h>
+
+#include "./types.h"
+
+#define HASH_PRIME_1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4FULL
+
+static inline u64 hash_rotl(const u64 x, const int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline u64 hash_begin(const size_t size, const u64 seed) {
+	return seed ^ (size * HASH_PRIME_1);
+}
+
+/**
+ * @brief Feed `size` bytes into `hash`. Data may be fed in several chunks, as
+ *        long as all but the last one are a multiple of eight bytes long.
+ */
+static inline u64 hash_update(u64 hash, const u8 *restrict const data, const size_t size) {
+	size_t i = 0ULL;
+	for (; (i + 8ULL) <= size; i += 8ULL) {
+		u64 word;
+		memcpy(&word, data + i, sizeof(word));
+		hash = hash_rotl(hash ^ (word * HASH_PRIME_2), 31) * HASH_PRIME_1;
+	}
+
+	for (; i < size; i++) {
+		hash = hash_rotl(hash ^ (data[i] * HASH_PRIME_2), 11) * HASH_PRIME_1;
+	}
+
+	return hash;
+}
+
+static inline u64 hash_finish(u64 hash) {
+	hash ^= hash >> 33;
+	hash *= HASH_PRIME_2;
+	hash ^= hash >> 29;
+
+	return hash;
+}
+
+/**
+ * @brief A fast, non-cryptographic 64-bit hash that consumes eight bytes per
+ *        step. Good enough to tell apart pages of memory, not suitable for
+ *        anything security related.
+ */
+static inline u64 hash_bytes(const u8 *restrict const data, const size_t size, const u64 seed) {
+	return hash_finish(hash_update(hash_begin(size, seed), data, size));
+}
+
+#endif
@@ -0,0 +1,225 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__HOOKS_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__HOOKS_H_ 1
+
+/**
+ * Lua callbacks for game functions hooked by the mod.
+ *
+ * Hook names (e.g. `"Player_Update"`) are interned into small integer ids,
+ * once by the script that registers a callback with `Recomp.on()` and once by
+ * the mod when it first calls `LuaLoader_GetHookId()`. From then on, running a
+ * hook means indexing a fixed array of callback lists with its id and calling
+ * each callback straight from the registry by its `luaL_ref()` reference; no
+ * global, table or string lookups happen on the way.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "../lua/src/lua.h"
+#include "../lua/src/lualib.h"
+#include "../lua/src/lauxlib.h"
+
+#include "./logging.h"
+#include "./types.h"
+
+// The maximum number of distinct hook names per Lua state.
+#define HOOK_DISPATCHER_MAX_HOOKS 256ULL
+
+// The most arguments a hook can pass on to its callbacks.
+#define HOOK_DISPATCHER_MAX_ARGS 2
+
+#define HookDispatcher__name "LuaLoader::HookDispatcher"
+
+// Where the dispatcher of a state is kept in its registry; the metatable
+// already takes `HookDispatcher__name`.
+#define HookDispatcher__registry_key "LuaLoader::HookDispatcher::instance"
+
+typedef struct HookCallbackList {
+	int *refs; // references into `LUA_REGISTRYINDEX`
+	u32 count;
+	u32 capacity;
+} HookCallbackList;
+
+/**
+ * Lives in a userdata owned by its Lua state. Its user value is a table that
+ * maps every interned hook name to its id and every id back to its name.
+ */
+typedef struct HookDispatcher {
+	u32 hook_count;
+	// Indexed by hook id minus one, so that `0` can mean "no hook".
+	HookCallbackList lists[HOOK_DISPATCHER_MAX_HOOKS];
+} HookDispatcher;
+
+static inline int hook_dispatcher_gc(lua_State *L) {
+	HookDispatcher *dispatcher = (HookDispatcher *)luaL_checkudata(L, 1, HookDispatcher__name);
+
+	// The references themselves go away with the registry.
+	for (u32 i = 0; i < dispatcher->hook_count; i++) {
+		free(dispatcher->lists[i].refs);
+		dispatcher->lists[i] = (HookCallbackList){ 0 };
+	}
+	dispatcher->hook_count = 0;
+
+	return 0;
+}
+
+/**
+ * @brief Create the dispatcher of `L`, push it onto the stack and anchor it in
+ *        the registry, so that it lives exactly as long as `L`.
+ */
+static inline HookDispatcher *hook_dispatcher_new(lua_State *L) {
+	HookDispatcher *dispatcher = (HookDispatcher *)lua_newuserdatauv(L, sizeof(HookDispatcher), 1);
+	*dispatcher = (HookDispatcher){ 0 };
+
+	if (luaL_newmetatable(L, HookDispatcher__name)) {
+		lua_pushcfunction(L, hook_dispatcher_gc);
+		lua_setfield(L, -2, "__gc");
+	}
+	lua_setmetatable(L, -2);
+
+	lua_newtable(L);
+	lua_setiuservalue(L, -2, 1);
+
+	lua_pushvalue(L, -1);
+	lua_setfield(L, LUA_REGISTRYINDEX, HookDispatcher__registry_key);
+
+	return dispatcher;
+}
+
+/**
+ * @brief Push the dispatcher of `L` that `hook_dispatcher_new()` created.
+ */
+static inline HookDispatcher *hook_dispatcher_push(lua_State *L) {
+	lua_getfield(L, LUA_REGISTRYINDEX, HookDispatcher__registry_key);
+	return (HookDispatcher *)luaL_testudata(L, -1, HookDispatcher__name);
+}
+
+/**
+ * @param dispatcher_index The stack index of the dispatcher userdata.
+ * @return The id of the hook called `name`, which gets assigned on first use,
+ *         or `0` if there is no room for another hook.
+ */
+static inline u32 hook_dispatcher_intern(lua_State *L, const int dispatcher_index, const char *name) {
+	HookDispatcher *dispatcher = (HookDispatcher *)lua_touserdata(L, dispatcher_index);
+
+	lua_getiuservalue(L, dispatcher_index, 1);
+	if (lua_getfield(L, -1, name) == LUA_TNUMBER) {
+		const u32 hook_id = (u32)lua_tointeger(L, -1);
+		lua_pop(L, 2);
+		return hook_id;
+	}
+	lua_pop(L, 1);
+
+	if (dispatcher->hook_count >= HOOK_DISPATCHER_MAX_HOOKS) {
+		lua_pop(L, 1);
+		return 0;
+	}
+
+	dispatcher->hook_count++;
+	const u32 hook_id = dispatcher->hook_count;
+
+	lua_pushinteger(L, (lua_Integer)hook_id);
+	lua_setfield(L, -2, name);
+	lua_pushstring(L, name);
+	lua_rawseti(L, -2, (lua_Integer)hook_id);
+	lua_pop(L, 1);
+
+	return hook_id;
+}
+
+/**
+ * @brief Append the function at `function_index` to the callbacks of the hook
+ *        `hook_id`.
+ * @return `false` if out of memory.
+ */
+static inline bool hook_dispatcher_add(lua_State *L, HookDispatcher *restrict const dispatcher, const u32 hook_id, const int function_index) {
+	HookCallbackList *list = &(dispatcher->lists[hook_id - 1]);
+
+	if (list->count >= list->capacity) {
+		const u32 capacity = (list->capacity == 0) ? 4 : (list->capacity * 2);
+		int *refs = (int *)realloc(list->refs, (size_t)capacity * sizeof(int));
+		if (refs == NULL) {
+			return false;
+		}
+
+		list->refs = refs;
+		list->capacity = capacity;
+	}
+
+	lua_pushvalue(L, function_index);
+	list->refs[list->count] = luaL_ref(L, LUA_REGISTRYINDEX);
+	list->count++;
+
+	return true;
+}
+
+/**
+ * @brief Call every callback of the hook `hook_id` with `args`, in the order
+ *        they were added. An error in one callback is logged and does not
+ *        stop the others. Callbacks added while this runs are first called
+ *        the next time around.
+ */
+static inline void hook_dispatcher_dispatch(
+		lua_State *L,
+		const HookDispatcher *dispatcher,
+		const u32 hook_id,
+		const lua_Integer *restrict const args,
+		const int arg_count
+) {
+	if ((hook_id == 0) || (hook_id > dispatcher->hook_count)) {
+		LOG("Invalid hook id %"PRIu32"!", hook_id);
+		return;
+	}
+
+	const HookCallbackList *list = &(dispatcher->lists[hook_id - 1]);
+	const u32 count = list->count;
+	const int top = lua_gettop(L);
+
+	for (u32 i = 0; i < count; i++) {
+		// `list->refs` may have been moved by a callback calling `Recomp.on()`.
+		lua_rawgeti(L, LUA_REGISTRYINDEX, list->refs[i]);
+		for (int j = 0; j < arg_count; j++) {
+			lua_pushinteger(L, args[j]);
+		}
+
+		if (lua_pcall(L, arg_count, 0, 0) != LUA_OK) {
+			const char *error_message = lua_tostring(L, -1);
+			if (error_message == NULL) error_message = "<unknown error>";
+			LOG("Lua runtime error in callback #%"PRIu32" of hook %"PRIu32":\n    %s", i + 1, hook_id, error_message);
+		}
+
+		lua_settop(L, top);
+	}
+}
+
+/**
+ * `Recomp.on(name, callback)`: Call `callback` whenever the mod dispatches the
+ * hook `name`. The only upvalue is the dispatcher userdata.
+ *
+ * @return The id of the hook.
+ */
+static inline int hook_dispatcher_lua_on(lua_State *L) {
+	const char *name = luaL_checkstring(L, 1);
+	luaL_checktype(L, 2, LUA_TFUNCTION);
+
+	HookDispatcher *dispatcher = (HookDispatcher *)lua_touserdata(L, lua_upvalueindex(1));
+
+	const u32 hook_id = hook_dispatcher_intern(L, lua_upvalueindex(1), name);
+	if (hook_id == 0) {
+		return luaL_error(L, "Cannot register more than %d different hooks!", (int)HOOK_DISPATCHER_MAX_HOOKS);
+	}
+
+	if (!hook_dispatcher_add(L, dispatcher, hook_id, 2)) {
+		return luaL_error(L, "Not enough memory to add a callback to hook \"%s\"!", name);
+	}
+
+	lua_pushinteger(L, (lua_Integer)hook_id);
+
+	return 1;
+}
+
+#endif
@@ -0,0 +1,437 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__LUA_PATTERN_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__LUA_PATTERN_H_ 1
+
+/**
+ * The Lua pattern matcher from `lstrlib.c` (Lua 5.4.7), adapted to run over a
+ * window of a larger subject instead of a complete Lua string.
+ *
+ * The matching logic itself is unchanged, except that the matcher records in
+ * `hit_end` whenever its result depended on where the subject ends (e.g.
+ * because a `.*` ran into it, or `$` was tested against it). If that happens
+ * while the window does not yet reach the end of the actual subject, the
+ * caller must retry with a larger window. Everything else behaves exactly
+ * like `string.match()`, with two differences:
+ *
+ * - The byte before `src_init` must be readable; it is used as the preceding
+ *   character for `%f` (and must be `'\0'` at the start of the subject, which
+ *   is what `lstrlib.c` assumes).
+ * - Position captures are offset by `position_offset`.
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../lua/src/lua.h"
+#include "../lua/src/lauxlib.h"
+
+#include "./types.h"
+
+#if !defined(LUA_MAXCAPTURES)
+#define LUA_MAXCAPTURES 32
+#endif
+
+#define LUA_PATTERN_MAX_CALLS 200
+
+#define LUA_PATTERN_CAP_UNFINISHED (-1)
+#define LUA_PATTERN_CAP_POSITION   (-2)
+
+#define LUA_PATTERN_ESC '%'
+#define LUA_PATTERN_SPECIALS "^$*+?.([%-"
+
+#define LUA_PATTERN_UCHAR(c) ((unsigned char)(c))
+
+typedef struct LuaPatternMatchState {
+	const char *src_init; // start of the window
+	const char *src_end;  // end of the window
+	const char *p_end;    // end of the pattern
+	lua_State *L;
+	int matchdepth;
+	unsigned char level;
+	bool hit_end;
+	lua_Integer position_offset;
+	struct {
+		const char *init;
+		ptrdiff_t len;
+	} capture[LUA_MAXCAPTURES];
+} LuaPatternMatchState;
+
+static inline const char *lua_pattern_match(LuaPatternMatchState *ms, const char *s, const char *p);
+
+static inline int lua_pattern_check_capture(LuaPatternMatchState *ms, int l) {
+	l -= '1';
+	if ((l < 0) || (l >= ms->level) || (ms->capture[l].len == LUA_PATTERN_CAP_UNFINISHED)) {
+		return luaL_error(ms->L, "invalid capture index %%%d", l + 1);
+	}
+	return l;
+}
+
+static inline int lua_pattern_capture_to_close(LuaPatternMatchState *ms) {
+	int level = ms->level;
+	for (level--; level >= 0; level--) {
+		if (ms->capture[level].len == LUA_PATTERN_CAP_UNFINISHED) {
+			return level;
+		}
+	}
+	return luaL_error(ms->L, "invalid pattern capture");
+}
+
+static inline const char *lua_pattern_classend(LuaPatternMatchState *ms, const char *p) {
+	switch (*p++) {
+		case LUA_PATTERN_ESC: {
+			if (p == ms->p_end) {
+				luaL_error(ms->L, "malformed pattern (ends with '%%')");
+			}
+			return p + 1;
+		}
+		case '[': {
+			if (*p == '^') {
+				p++;
+			}
+			do { // look for a ']'
+				if (p == ms->p_end) {
+					luaL_error(ms->L, "malformed pattern (missing ']')");
+				}
+				if ((*(p++) == LUA_PATTERN_ESC) && (p < ms->p_end)) {
+					p++; // skip escapes (e.g. '%]')
+				}
+			} while (*p != ']');
+			return p + 1;
+		}
+		default: {
+			return p;
+		}
+	}
+}
+
+static inline int lua_pattern_match_class(int c, int cl) {
+	int res;
+	switch (tolower(cl)) {
+		case 'a': res = isalpha(c);  break;
+		case 'c': res = iscntrl(c);  break;
+		case 'd': res = isdigit(c);  break;
+		case 'g': res = isgraph(c);  break;
+		case 'l': res = islower(c);  break;
+		case 'p': res = ispunct(c);  break;
+		case 's': res = isspace(c);  break;
+		case 'u': res = isupper(c);  break;
+		case 'w': res = isalnum(c);  break;
+		case 'x': res = isxdigit(c); break;
+		case 'z': res = (c == 0);    break; // deprecated option
+		default: return (cl == c);
+	}
+	return (islower(cl) ? res : !res);
+}
+
+static inline int lua_pattern_matchbracketclass(int c, const char *p, const char *ec) {
+	int sig = 1;
+	if (*(p + 1) == '^') {
+		sig = 0;
+		p++; // skip the '^'
+	}
+	while (++p < ec) {
+		if (*p == LUA_PATTERN_ESC) {
+			p++;
+			if (lua_pattern_match_class(c, LUA_PATTERN_UCHAR(*p))) {
+				return sig;
+			}
+		} else if ((*(p + 1) == '-') && ((p + 2) < ec)) {
+			p += 2;
+			if ((LUA_PATTERN_UCHAR(*(p - 2)) <= c) && (c <= LUA_PATTERN_UCHAR(*p))) {
+				return sig;
+			}
+		} else if (LUA_PATTERN_UCHAR(*p) == c) {
+			return sig;
+		}
+	}
+	return !sig;
+}
+
+static inline int lua_pattern_singlematch(LuaPatternMatchState *ms, const char *s, const char *p, const char *ep) {
+	if (s >= ms->src_end) {
+		ms->hit_end = true;
+		return 0;
+	}
+
+	int c = LUA_PATTERN_UCHAR(*s);
+	switch (*p) {
+		case '.': return 1; // matches any char
+		case LUA_PATTERN_ESC: return lua_pattern_match_class(c, LUA_PATTERN_UCHAR(*(p + 1)));
+		case '[': return lua_pattern_matchbracketclass(c, p, ep - 1);
+		default:  return (LUA_PATTERN_UCHAR(*p) == c);
+	}
+}
+
+static inline const char *lua_pattern_matchbalance(LuaPatternMatchState *ms, const char *s, const char *p) {
+	if (p >= (ms->p_end - 1)) {
+		luaL_error(ms->L, "malformed pattern (missing arguments to '%%b')");
+	}
+	if (s >= ms->src_end) {
+		ms->hit_end = true;
+		return NULL;
+	}
+	if (*s != *p) {
+		return NULL;
+	}
+
+	int b = *p;
+	int e = *(p + 1);
+	int cont = 1;
+	while (++s < ms->src_end) {
+		if (*s == e) {
+			if (--cont == 0) {
+				return s + 1;
+			}
+		} else if (*s == b) {
+			cont++;
+		}
+	}
+
+	ms->hit_end = true;
+	return NULL; // string ends out of balance
+}
+
+static inline const char *lua_pattern_max_expand(LuaPatternMatchState *ms, const char *s, const char *p, const char *ep) {
+	ptrdiff_t i = 0; // counts maximum expand for item
+	while (lua_pattern_singlematch(ms, s + i, p, ep)) {
+		i++;
+	}
+	// keeps trying to match with the maximum repetitions
+	while (i >= 0) {
+		const char *res = lua_pattern_match(ms, (s + i), ep + 1);
+		if (res) {
+			return res;
+		}
+		i--; // else didn't match; reduce 1 repetition to try again
+	}
+	return NULL;
+}
+
+static inline const char *lua_pattern_min_expand(LuaPatternMatchState *ms, const char *s, const char *p, const char *ep) {
+	for (;;) {
+		const char *res = lua_pattern_match(ms, s, ep + 1);
+		if (res != NULL) {
+			return res;
+		} else if (lua_pattern_singlematch(ms, s, p, ep)) {
+			s++; // try with one more repetition
+		} else {
+			return NULL;
+		}
+	}
+}
+
+static inline const char *lua_pattern_start_capture(LuaPatternMatchState *ms, const char *s, const char *p, int what) {
+	const char *res;
+	int level = ms->level;
+	if (level >= LUA_MAXCAPTURES) {
+		luaL_error(ms->L, "too many captures");
+	}
+	ms->capture[level].init = s;
+	ms->capture[level].len = what;
+	ms->level = level + 1;
+	if ((res = lua_pattern_match(ms, s, p)) == NULL) { // match failed?
+		ms->level--; // undo capture
+	}
+	return res;
+}
+
+static inline const char *lua_pattern_end_capture(LuaPatternMatchState *ms, const char *s, const char *p) {
+	int l = lua_pattern_capture_to_close(ms);
+	const char *res;
+	ms->capture[l].len = s - ms->capture[l].init; // close capture
+	if ((res = lua_pattern_match(ms, s, p)) == NULL) { // match failed?
+		ms->capture[l].len = LUA_PATTERN_CAP_UNFINISHED; // undo capture
+	}
+	return res;
+}
+
+static inline const char *lua_pattern_match_capture(LuaPatternMatchState *ms, const char *s, int l) {
+	size_t len;
+	l = lua_pattern_check_capture(ms, l);
+	len = (size_t)ms->capture[l].len;
+	if ((size_t)(ms->src_end - s) < len) {
+		ms->hit_end = true;
+		return NULL;
+	}
+	if (memcmp(ms->capture[l].init, s, len) == 0) {
+		return s + len;
+	}
+	return NULL;
+}
+
+static inline const char *lua_pattern_match(LuaPatternMatchState *ms, const char *s, const char *p) {
+	if (ms->matchdepth-- == 0) {
+		luaL_error(ms->L, "pattern too complex");
+	}
+	init: // using goto to optimize tail recursion
+	if (p != ms->p_end) { // end of pattern?
+		switch (*p) {
+			case '(': { // start capture
+				if (*(p + 1) == ')') { // position capture?
+					s = lua_pattern_start_capture(ms, s, p + 2, LUA_PATTERN_CAP_POSITION);
+				} else {
+					s = lua_pattern_start_capture(ms, s, p + 1, LUA_PATTERN_CAP_UNFINISHED);
+				}
+				break;
+			}
+			case ')': { // end capture
+				s = lua_pattern_end_capture(ms, s, p + 1);
+				break;
+			}
+			case '$': {
+				if ((p + 1) != ms->p_end) { // is the '$' the last char in pattern?
+					goto dflt; // no; go to default
+				}
+				if (s == ms->src_end) { // check end of string
+					ms->hit_end = true;
+				} else {
+					s = NULL;
+				}
+				break;
+			}
+			case LUA_PATTERN_ESC: { // escaped sequences not in the format class[*+?-]?
+				switch (*(p + 1)) {
+					case 'b': { // balanced string?
+						s = lua_pattern_matchbalance(ms, s, p + 2);
+						if (s != NULL) {
+							p += 4;
+							goto init; // return match(ms, s, p + 4);
+						} // else fail (s == NULL)
+						break;
+					}
+					case 'f': { // frontier?
+						const char *ep;
+						char previous;
+						p += 2;
+						if (*p != '[') {
+							luaL_error(ms->L, "missing '[' after '%%f' in pattern");
+						}
+						ep = lua_pattern_classend(ms, p); // points to what is next
+						previous = *(s - 1); // see the top of this file
+						if (s >= ms->src_end) {
+							ms->hit_end = true;
+						}
+						if (
+							!lua_pattern_matchbracketclass(LUA_PATTERN_UCHAR(previous), p, ep - 1) &&
+							lua_pattern_matchbracketclass(LUA_PATTERN_UCHAR(*s), p, ep - 1)
+						) {
+							p = ep;
+							goto init; // return match(ms, s, ep);
+						}
+						s = NULL; // match failed
+						break;
+					}
+					case '0': case '1': case '2': case '3':
+					case '4': case '5': case '6': case '7':
+					case '8': case '9': { // capture results (%0-%9)?
+						s = lua_pattern_match_capture(ms, s, LUA_PATTERN_UCHAR(*(p + 1)));
+						if (s != NULL) {
+							p += 2;
+							goto init; // return match(ms, s, p + 2)
+						}
+						break;
+					}
+					default: {
+						goto dflt;
+					}
+				}
+				break;
+			}
+			default: dflt: { // pattern class plus optional suffix
+				const char *ep = lua_pattern_classend(ms, p); // points to optional suffix
+				// does not match at least once?
+				if (!lua_pattern_singlematch(ms, s, p, ep)) {
+					if ((*ep == '*') || (*ep == '?') || (*ep == '-')) { // accept empty?
+						p = ep + 1;
+						goto init; // return match(ms, s, ep + 1);
+					} else { // '+' or no suffix
+						s = NULL; // fail
+					}
+				} else { // matched once
+					switch (*ep) { // handle optional suffix
+						case '?': { // optional
+							const char *res;
+							if ((res = lua_pattern_match(ms, s + 1, ep + 1)) != NULL) {
+								s = res;
+							} else {
+								p = ep + 1;
+								goto init; // else return match(ms, s, ep + 1);
+							}
+							break;
+						}
+						case '+': { // 1 or more repetitions
+							s = lua_pattern_max_expand(ms, s + 1, p, ep); // 1 match already done
+							break;
+						}
+						case '*': { // 0 or more repetitions
+							s = lua_pattern_max_expand(ms, s, p, ep);
+							break;
+						}
+						case '-': { // 0 or more repetitions (minimum)
+							s = lua_pattern_min_expand(ms, s, p, ep);
+							break;
+						}
+						default: { // no suffix
+							s++;
+							p = ep;
+							goto init; // return match(ms, s + 1, ep);
+						}
+					}
+				}
+				break;
+			}
+		}
+	}
+	ms->matchdepth++;
+	return s;
+}
+
+/**
+ * @brief Push the `i`-th capture onto the stack, or the whole match `s`..`e`
+ *        if there are no captures and `i` is `0`.
+ */
+static inline void lua_pattern_push_onecapture(LuaPatternMatchState *ms, int i, const char *s, const char *e) {
+	if (i >= ms->level) {
+		if (i != 0) {
+			luaL_error(ms->L, "invalid capture index %%%d", i + 1);
+		}
+		lua_pushlstring(ms->L, s, (size_t)(e - s));
+		return;
+	}
+
+	ptrdiff_t capl = ms->capture[i].len;
+	if (capl == LUA_PATTERN_CAP_UNFINISHED) {
+		luaL_error(ms->L, "unfinished capture");
+	} else if (capl == LUA_PATTERN_CAP_POSITION) {
+		lua_pushinteger(ms->L, (lua_Integer)(ms->capture[i].init - ms->src_init) + 1LL + ms->position_offset);
+	} else {
+		lua_pushlstring(ms->L, ms->capture[i].init, (size_t)capl);
+	}
+}
+
+static inline int lua_pattern_push_captures(LuaPatternMatchState *ms, const char *s, const char *e) {
+	int nlevels = ((ms->level == 0) && s) ? 1 : ms->level;
+	luaL_checkstack(ms->L, nlevels, "too many captures");
+	for (int i = 0; i < nlevels; i++) {
+		lua_pattern_push_onecapture(ms, i, s, e);
+	}
+	return nlevels; // number of strings pushed
+}
+
+/**
+ * @brief Check whether every match of the pattern `p` has to start with the
+ *        literal character `*p`, so candidates can be skipped with `memchr()`.
+ */
+static inline bool lua_pattern_starts_with_literal(const char *p, const char *p_end) {
+	// Note that `strchr()` also finds the terminating `'\0'`.
+	if ((p == p_end) || (strchr(LUA_PATTERN_SPECIALS ")", *p) != NULL)) {
+		return false;
+	}
+
+	return ((p + 1) == p_end) || ((p[1] != '*') && (p[1] != '?') && (p[1] != '-'));
+}
+
+#endif
@@ -0,0 +1,206 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__LZ_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__LZ_H_ 1
+
+/**
+ * A small LZ77 codec in the spirit of LZ4, tuned for compressing single pages
+ * of memory.
+ *
+ * The compressed stream is a list of sequences. Each sequence starts with a
+ * token byte whose high nibble holds the number of literals and whose low
+ * nibble holds the match length minus `LZ_MIN_MATCH`. A nibble value of 15
+ * means that more length bytes follow, each of which is added to it until one
+ * of them is not 255. The literals come next, followed by the match offset as
+ * a 16-bit little-endian integer. The last sequence consists of literals only.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "./types.h"
+
+#define LZ_MIN_MATCH     4ULL
+#define LZ_LAST_LITERALS 5ULL
+#define LZ_MAX_OFFSET    0xFFFFULL
+#define LZ_HASH_BITS     12
+
+static inline u32 lz_read_u32(const u8 *ptr) {
+	u32 value;
+	memcpy(&value, ptr, sizeof(value));
+	return value;
+}
+
+static inline u32 lz_hash(u32 sequence) {
+	return (sequence * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+static inline bool lz_write_length(u8 *dst, size_t *restrict const op, const size_t dst_capacity, size_t length) {
+	for (; length >= 255ULL; length -= 255ULL) {
+		if (*op >= dst_capacity) return false;
+		dst[(*op)++] = 255;
+	}
+
+	if (*op >= dst_capacity) return false;
+	dst[(*op)++] = (u8)length;
+
+	return true;
+}
+
+static inline bool lz_write_sequence(
+		u8 *dst,
+		size_t *restrict const op,
+		const size_t dst_capacity,
+		const u8 *literals,
+		const size_t literal_length,
+		const size_t offset,
+		const size_t match_length
+) {
+	if (*op >= dst_capacity) return false;
+
+	const size_t token_index = (*op)++;
+	u8 token = 0;
+
+	if (literal_length >= 15ULL) {
+		token |= 15U << 4;
+		if (!lz_write_length(dst, op, dst_capacity, literal_length - 15ULL)) return false;
+	} else {
+		token |= (u8)(literal_length << 4);
+	}
+
+	if ((*op + literal_length) > dst_capacity) return false;
+	memcpy(dst + *op, literals, literal_length);
+	*op += literal_length;
+
+	if (match_length != 0ULL) {
+		if ((*op + 2ULL) > dst_capacity) return false;
+		dst[(*op)++] = (u8)((offset >> 0) & 0xFFULL);
+		dst[(*op)++] = (u8)((offset >> 8) & 0xFFULL);
+
+		const size_t match_code = match_length - LZ_MIN_MATCH;
+		if (match_code >= 15ULL) {
+			token |= 15U;
+			if (!lz_write_length(dst, op, dst_capacity, match_code - 15ULL)) return false;
+		} else {
+			token |= (u8)match_code;
+		}
+	}
+
+	dst[token_index] = token;
+
+	return true;
+}
+
+/**
+ * @brief Compress `src` into `dst`.
+ * @return The compressed size in bytes, or `0` if the result would not fit
+ *         into `dst_capacity` bytes (which means the data is incompressible if
+ *         `dst_capacity` is less than `src_size`).
+ */
+static inline size_t lz_compress(const u8 *restrict const src, const size_t src_size, u8 *restrict const dst, const size_t dst_capacity) {
+	u32 table[1U << LZ_HASH_BITS];
+	memset(table, 0, sizeof(table));
+
+	size_t op = 0ULL;
+	size_t anchor = 0ULL;
+	size_t ip = 0ULL;
+
+	if (src_size > (LZ_MIN_MATCH + LZ_LAST_LITERALS)) {
+		const size_t match_limit = src_size - LZ_LAST_LITERALS;
+
+		while ((ip + LZ_MIN_MATCH) <= match_limit) {
+			const u32 sequence = lz_read_u32(src + ip);
+			const u32 hash = lz_hash(sequence);
+
+			// Positions are stored off by one, so that `0` means "empty".
+			const size_t candidate = (size_t)table[hash];
+			table[hash] = (u32)(ip + 1ULL);
+
+			if (
+				(candidate == 0ULL) ||
+				((ip - (candidate - 1ULL)) > LZ_MAX_OFFSET) ||
+				(lz_read_u32(src + candidate - 1ULL) != sequence)
+			) {
+				ip++;
+				continue;
+			}
+
+			const size_t match = candidate - 1ULL;
+			size_t match_length = LZ_MIN_MATCH;
+			while (((ip + match_length) < match_limit) && (src[match + match_length] == src[ip + match_length])) {
+				match_length++;
+			}
+
+			if (!lz_write_sequence(dst, &op, dst_capacity, src + anchor, ip - anchor, ip - match, match_length)) {
+				return 0ULL;
+			}
+
+			ip += match_length;
+			anchor = ip;
+		}
+	}
+
+	if (!lz_write_sequence(dst, &op, dst_capacity, src + anchor, src_size - anchor, 0ULL, 0ULL)) {
+		return 0ULL;
+	}
+
+	return op;
+}
+
+static inline bool lz_read_length(const u8 *src, size_t *restrict const ip, const size_t src_size, size_t *restrict const length) {
+	u8 byte = 0;
+	do {
+		if (*ip >= src_size) return false;
+		byte = src[(*ip)++];
+		*length += byte;
+	} while (byte == 255);
+
+	return true;
+}
+
+/**
+ * @brief Decompress `src` into `dst`. The input is fully validated, so it is
+ *        safe to pass untrusted data.
+ * @return `true` if `src` decompressed into exactly `dst_size` bytes.
+ */
+static inline bool lz_decompress(const u8 *restrict const src, const size_t src_size, u8 *restrict const dst, const size_t dst_size) {
+	size_t ip = 0ULL;
+	size_t op = 0ULL;
+
+	while (ip < src_size) {
+		const u8 token = src[ip++];
+
+		size_t literal_length = (size_t)(token >> 4);
+		if ((literal_length == 15ULL) && !lz_read_length(src, &ip, src_size, &literal_length)) return false;
+
+		if (((ip + literal_length) > src_size) || ((op + literal_length) > dst_size)) return false;
+		memcpy(dst + op, src + ip, literal_length);
+		ip += literal_length;
+		op += literal_length;
+
+		if (ip == src_size) break;
+
+		if ((ip + 2ULL) > src_size) return false;
+		const size_t offset = ((size_t)src[ip]) | (((size_t)src[ip + 1ULL]) << 8);
+		ip += 2ULL;
+
+		if ((offset == 0ULL) || (offset > op)) return false;
+
+		size_t match_length = (size_t)(token & 15U);
+		if ((match_length == 15ULL) && !lz_read_length(src, &ip, src_size, &match_length)) return false;
+		match_length += LZ_MIN_MATCH;
+
+		if ((op + match_length) > dst_size) return false;
+
+		// Matches may overlap with their own output, so this has to be a
+		// forward byte-by-byte copy rather than `memcpy()`.
+		for (size_t i = 0ULL; i < match_length; i++, op++) {
+			dst[op] = dst[op - offset];
+		}
+	}
+
+	return op == dst_size;
+}
+
+#endif
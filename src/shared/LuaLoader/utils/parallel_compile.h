@@ -0,0 +1,216 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__PARALLEL_COMPILE_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__PARALLEL_COMPILE_H_ 1
+
+/**
+ * Compiles many Lua scripts at once on worker threads.
+ *
+ * A single `lua_State` can only ever parse one chunk at a time, but separate
+ * states share nothing, so every worker parses (or fetches from the bytecode
+ * cache, see `utils/bytecode_cache.h`) its files in a private scratch state
+ * and hands back the output of `lua_dump()`. All that is left to do for the
+ * state that runs the scripts is to load that bytecode, which is far cheaper
+ * than parsing. Loading all scripts takes about as long as parsing the
+ * largest one, rather than all of them one after another.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "../lua/src/lua.h"
+#include "../lua/src/lualib.h"
+#include "../lua/src/lauxlib.h"
+
+#include "./bytecode_cache.h"
+#include "./types.h"
+
+// Including the calling thread, which works on jobs as well.
+#define PARALLEL_COMPILE_MAX_THREADS 8ULL
+
+typedef struct CompileJob {
+	const char *file_path;
+	// Exactly one of these is set once the job is done; both are allocated
+	// with `malloc()` and owned by the caller from then on.
+	u8 *bytecode;
+	char *error_message;
+	size_t bytecode_size;
+	// Set by `parallel_compile()` if an earlier job has the same path. Such
+	// jobs are not compiled again (two workers would also race on the same
+	// cache file), but get a copy of that job's result.
+	const struct CompileJob *duplicate_of;
+} CompileJob;
+
+typedef struct ParallelCompiler {
+	mtx_t mutex;
+	CompileJob *jobs;
+	size_t job_count;
+	size_t next_job;
+} ParallelCompiler;
+
+static inline char *parallel_compile_strdup(const char *str) {
+	const size_t size = strlen(str) + 1ULL;
+	char *copy = (char *)malloc(size);
+	if (copy != NULL) {
+		memcpy(copy, str, size);
+	}
+
+	return copy;
+}
+
+static inline void parallel_compile_run_job(lua_State *L, CompileJob *restrict const job) {
+	// Reads and hashes the file once, and on a cache miss hands back the same
+	// dump that was written to the cache.
+	BytecodeCacheDumpBuffer bytecode = { 0 };
+	if (bytecode_cache_load_file_ex(L, job->file_path, &bytecode) != LUA_OK) {
+		const char *error_message = lua_tostring(L, -1);
+		job->error_message = parallel_compile_strdup((error_message != NULL) ? error_message : "<unknown error>");
+		return;
+	}
+
+	job->bytecode = bytecode.data;
+	job->bytecode_size = bytecode.size;
+}
+
+static inline int parallel_compile_thread_main(void *arg) {
+	ParallelCompiler *compiler = (ParallelCompiler *)arg;
+
+	lua_State *L = luaL_newstate();
+	if (L == NULL) {
+		return 0;
+	}
+
+	while (true) {
+		mtx_lock(&(compiler->mutex));
+		const size_t i = compiler->next_job;
+		if (i < compiler->job_count) {
+			compiler->next_job++;
+		}
+		mtx_unlock(&(compiler->mutex));
+
+		if (i >= compiler->job_count) {
+			break;
+		}
+
+		if (compiler->jobs[i].duplicate_of == NULL) {
+			parallel_compile_run_job(L, &(compiler->jobs[i]));
+			lua_settop(L, 0);
+		}
+	}
+
+	lua_close(L);
+
+	return 0;
+}
+
+/**
+ * @brief Compile the file of every job in `jobs` and wait until all are done.
+ *        Uses at most one thread per core, and falls back to fewer threads
+ *        (down to just the calling one) if threads cannot be created.
+ */
+static inline void parallel_compile(CompileJob *restrict const jobs, const size_t job_count) {
+	ParallelCompiler compiler = { .jobs = jobs, .job_count = job_count, .next_job = 0ULL };
+
+	// There are only ever a handful of jobs, so a quadratic search is fine.
+	for (size_t i = 0; i < job_count; i++) {
+		jobs[i].duplicate_of = NULL;
+		for (size_t j = 0; j < i; j++) {
+			if ((jobs[j].duplicate_of == NULL) && (strcmp(jobs[i].file_path, jobs[j].file_path) == 0)) {
+				jobs[i].duplicate_of = &(jobs[j]);
+				break;
+			}
+		}
+	}
+
+	if (mtx_init(&(compiler.mutex), mtx_plain) != thrd_success) {
+		for (size_t i = 0; i < job_count; i++) {
+			jobs[i].error_message = parallel_compile_strdup("failed to initialize the compiler");
+		}
+		return;
+	}
+
+	// More threads than cores would only add overhead.
+	const long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t thread_count = (cpu_count > 0L) ? (size_t)cpu_count : 1ULL;
+	thread_count = (thread_count < PARALLEL_COMPILE_MAX_THREADS) ? thread_count : PARALLEL_COMPILE_MAX_THREADS;
+	thread_count = (thread_count < job_count) ? thread_count : job_count;
+	thrd_t threads[PARALLEL_COMPILE_MAX_THREADS];
+	size_t started_thread_count = 0ULL;
+	for (size_t i = 1; i < thread_count; i++) {
+		if (thrd_create(&(threads[started_thread_count]), parallel_compile_thread_main, &compiler) != thrd_success) {
+			break;
+		}
+		started_thread_count++;
+	}
+
+	parallel_compile_thread_main(&compiler);
+
+	for (size_t i = 0; i < started_thread_count; i++) {
+		thrd_join(threads[i], NULL);
+	}
+
+	mtx_destroy(&(compiler.mutex));
+
+	for (size_t i = 0; i < job_count; i++) {
+		const CompileJob *original = jobs[i].duplicate_of;
+		if (original == NULL) {
+			continue;
+		}
+
+		if (original->bytecode != NULL) {
+			jobs[i].bytecode = (u8 *)malloc(original->bytecode_size);
+			if (jobs[i].bytecode != NULL) {
+				memcpy(jobs[i].bytecode, original->bytecode, original->bytecode_size);
+				jobs[i].bytecode_size = original->bytecode_size;
+			}
+		} else if (original->error_message != NULL) {
+			jobs[i].error_message = parallel_compile_strdup(original->error_message);
+		}
+	}
+
+	// Only happens if not even one scratch state could be created, or if
+	// there was no memory left to copy a result.
+	for (size_t i = 0; i < job_count; i++) {
+		if ((jobs[i].bytecode == NULL) && (jobs[i].error_message == NULL)) {
+			jobs[i].error_message = parallel_compile_strdup("not enough memory to create a Lua state");
+		}
+	}
+}
+
+static inline void parallel_compile_free_jobs(CompileJob *restrict const jobs, const size_t job_count) {
+	for (size_t i = 0; i < job_count; i++) {
+		free(jobs[i].bytecode);
+		free(jobs[i].error_message);
+		jobs[i].bytecode = NULL;
+		jobs[i].error_message = NULL;
+	}
+}
+
+/**
+ * @brief Load the result of `job` into `L`, like `luaL_loadfilex()` would
+ *        have loaded its file.
+ */
+static inline int parallel_compile_load_result(lua_State *L, const CompileJob *restrict const job) {
+	if (job->bytecode == NULL) {
+		lua_pushstring(L, job->error_message);
+		return LUA_ERRSYNTAX;
+	}
+
+	const char *chunk_name = lua_pushfstring(L, "@%s", job->file_path);
+	const int status = luaL_loadbufferx(L, (const char *)(job->bytecode), job->bytecode_size, chunk_name, "b");
+	lua_remove(L, -2);
+	if (status == LUA_OK) {
+		return LUA_OK;
+	}
+
+	// A cache entry that passed its checks may still be rejected by
+	// `lundump.c` (e.g. one written by a differently configured build).
+	lua_pop(L, 1);
+	return bytecode_cache_load_file(L, job->file_path);
+}
+
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__PATTERN_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__PATTERN_H_ 1
+
+/**
+ * Byte signatures with wildcards, e.g. `"3C 08 ?? ?? 25 08"`, as used to find
+ * code and data that has been relocated.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "./types.h"
+
+#define BYTE_PATTERN_MAX_LENGTH 256ULL
+
+typedef struct BytePattern {
+	u8 bytes[BYTE_PATTERN_MAX_LENGTH];
+	bool is_wildcard[BYTE_PATTERN_MAX_LENGTH];
+	size_t length;
+	// The byte that candidates are searched for with `memchr()`, or
+	// `SIZE_MAX` if the whole pattern consists of wildcards.
+	size_t anchor;
+} BytePattern;
+
+static inline int byte_pattern_hex_digit(const char c) {
+	if ((c >= '0') && (c <= '9')) return c - '0';
+	if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+	if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+	return -1;
+}
+
+/**
+ * @brief Parse a pattern made up of two-digit hex bytes and `??` (or `?`)
+ *        wildcards, optionally separated by whitespace.
+ * @return `NULL` on success, or a description of what is wrong with `str`.
+ */
+static inline const char *byte_pattern_parse(BytePattern *restrict const pattern, const char *restrict const str, const size_t str_length) {
+	pattern->length = 0ULL;
+	pattern->anchor = SIZE_MAX;
+
+	for (size_t i = 0ULL; i < str_length;) {
+		const char c = str[i];
+		if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r')) {
+			i++;
+			continue;
+		}
+
+		if (pattern->length >= BYTE_PATTERN_MAX_LENGTH) {
+			return "pattern too long";
+		}
+
+		if (c == '?') {
+			i += ((i + 1ULL) < str_length) && (str[i + 1ULL] == '?') ? 2ULL : 1ULL;
+			pattern->bytes[pattern->length] = 0;
+			pattern->is_wildcard[pattern->length] = true;
+			pattern->length++;
+			continue;
+		}
+
+		const int high = byte_pattern_hex_digit(c);
+		const int low = ((i + 1ULL) < str_length) ? byte_pattern_hex_digit(str[i + 1ULL]) : -1;
+		if ((high < 0) || (low < 0)) {
+			return "expected a two-digit hex byte or a wildcard";
+		}
+
+		pattern->bytes[pattern->length] = (u8)((high << 4) | low);
+		pattern->is_wildcard[pattern->length] = false;
+		pattern->length++;
+		i += 2ULL;
+	}
+
+	if (pattern->length == 0ULL) {
+		return "empty pattern";
+	}
+
+	// Most of RDRAM is zeros (and some of it is filled with `0xFF`), so
+	// anchoring on either of those would turn up a candidate at nearly every
+	// position.
+	for (size_t i = 0ULL; i < pattern->length; i++) {
+		if (pattern->is_wildcard[i]) {
+			continue;
+		}
+
+		const bool is_common = (pattern->bytes[i] == 0x00) || (pattern->bytes[i] == 0xFF);
+		if ((pattern->anchor == SIZE_MAX) || (!is_common && (
+			(pattern->bytes[pattern->anchor] == 0x00) || (pattern->bytes[pattern->anchor] == 0xFF)
+		))) {
+			pattern->anchor = i;
+		}
+	}
+
+	return NULL;
+}
+
+static inline bool byte_pattern_matches_at(const BytePattern *restrict const pattern, const u8 *restrict const data) {
+	for (size_t i = 0ULL; i < pattern->length; i++) {
+		if (!pattern->is_wildcard[i] && (data[i] != pattern->bytes[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Find the first occurrence of `pattern` in `data`.
+ *
+ * Candidates are found by searching for the anchor byte with `memchr()`,
+ * which is vectorized by every libc worth using, and only then verified.
+ *
+ * @return The offset of the match, or `SIZE_MAX` if there is none.
+ */
+static inline size_t byte_pattern_find(const BytePattern *restrict const pattern, const u8 *restrict const data, const size_t size) {
+	if (size < pattern->length) {
+		return SIZE_MAX;
+	}
+
+	const size_t last_start = size - pattern->length;
+
+	if (pattern->anchor == SIZE_MAX) {
+		return 0ULL;
+	}
+
+	const size_t anchor = pattern->anchor;
+	const u8 anchor_byte = pattern->bytes[anchor];
+
+	for (size_t start = 0ULL; start <= last_start;) {
+		const u8 *hit = (const u8 *)memchr(data + start + anchor, anchor_byte, last_start - start + 1ULL);
+		if (hit == NULL) {
+			break;
+		}
+
+		const size_t candidate = (size_t)(hit - data) - anchor;
+		if (byte_pattern_matches_at(pattern, data + candidate)) {
+			return candidate;
+		}
+
+		start = candidate + 1ULL;
+	}
+
+	return SIZE_MAX;
+}
+
+#endif
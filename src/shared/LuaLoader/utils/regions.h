@@ -0,0 +1,161 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__REGIONS_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__REGIONS_H_ 1
+
+/**
+ * A map of the parts of RDRAM that are actually in use.
+ *
+ * The recomp reserves 512 MiB for N64 memory, but the game itself only ever
+ * sees 4 MiB (or 8 MiB with the expansion pak), plus whatever the recomp and
+ * mods allocate above that. Every operation that touches all of memory at once
+ * should stop at `RDRAMRegionMap.limit` instead of at the full capacity.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "./scan.h"
+#include "./swizzle.h"
+#include "./types.h"
+
+#define RDRAM_BASE_SIZE     0x00400000ULL
+#define RDRAM_EXPANDED_SIZE 0x00800000ULL
+
+// libultra stores the detected memory size in `osMemSize` at `0x80000318`.
+#define RDRAM_OS_MEM_SIZE_ADDRESS 0x00000318ULL
+
+// The heap region is rounded up to a multiple of `RDRAM_HEAP_ALIGNMENT` and
+// given `RDRAM_HEAP_HEADROOM` extra bytes of room to grow into after the map
+// has been built.
+#define RDRAM_HEAP_ALIGNMENT 0x00100000ULL
+#define RDRAM_HEAP_HEADROOM  0x00400000ULL
+
+// How many bytes past the end of the map `rdram_region_map_extend()` looks at
+// for signs that the heap has grown.
+#define RDRAM_HEAP_PROBE_LENGTH 0x00010000ULL
+
+#define RDRAM_REGION_MAP_MAX_REGIONS 3
+
+typedef struct RDRAMRegion {
+	const char *name;
+	size_t start;
+	size_t end;
+} RDRAMRegion;
+
+typedef struct RDRAMRegionMap {
+	RDRAMRegion regions[RDRAM_REGION_MAP_MAX_REGIONS];
+	size_t count;
+	size_t limit;
+} RDRAMRegionMap;
+
+static inline void rdram_region_map_push(RDRAMRegionMap *restrict const map, const char *name, size_t start, size_t end) {
+	if ((start >= end) || (map->count >= RDRAM_REGION_MAP_MAX_REGIONS)) {
+		return;
+	}
+
+	map->regions[map->count++] = (RDRAMRegion){ .name = name, .start = start, .end = end };
+	map->limit = end;
+}
+
+static inline size_t rdram_region_map_get_heap_end(const size_t high_water_mark, const size_t capacity) {
+	size_t heap_end = (high_water_mark + RDRAM_HEAP_ALIGNMENT - 1ULL) & ~(RDRAM_HEAP_ALIGNMENT - 1ULL);
+	heap_end += RDRAM_HEAP_HEADROOM;
+
+	return (heap_end < capacity) ? heap_end : capacity;
+}
+
+/**
+ * @brief Discover which parts of RDRAM are in use.
+ *
+ * The size of the game's own RAM is taken from `osMemSize`, falling back to
+ * the expansion pak size if that does not hold a sensible value (e.g. before
+ * the game has booted). Anything above it belongs to the recomp and to mods;
+ * its extent is found by a single scan for the highest non-zero byte.
+ *
+ * @param[out] map The region map to fill in.
+ * @param[in] raw_data The recomp's view of N64 memory.
+ * @param[in] capacity The number of bytes in `raw_data`.
+ */
+static inline void rdram_region_map_build(
+		RDRAMRegionMap *restrict const map,
+		const u8 *restrict const raw_data,
+		const size_t capacity
+) {
+	*map = (RDRAMRegionMap){ 0 };
+
+	size_t mem_size = RDRAM_EXPANDED_SIZE;
+	if (capacity >= RDRAM_OS_MEM_SIZE_ADDRESS + 4ULL) {
+		const size_t os_mem_size = (size_t)rdram_load_u32(raw_data, RDRAM_OS_MEM_SIZE_ADDRESS);
+		if ((os_mem_size == RDRAM_BASE_SIZE) || (os_mem_size == RDRAM_EXPANDED_SIZE)) {
+			mem_size = os_mem_size;
+		}
+	}
+
+	if (mem_size > capacity) {
+		mem_size = capacity;
+	}
+
+	const size_t base_size = (mem_size < RDRAM_BASE_SIZE) ? mem_size : RDRAM_BASE_SIZE;
+	rdram_region_map_push(map, "ram", 0ULL, base_size);
+	rdram_region_map_push(map, "expansion_pak", base_size, mem_size);
+
+	const size_t high_water_mark = rdram_find_occupied_length(raw_data, capacity);
+	if (high_water_mark > mem_size) {
+		rdram_region_map_push(map, "heap", mem_size, rdram_region_map_get_heap_end(high_water_mark, capacity));
+	}
+}
+
+/**
+ * @brief Grow the heap region of `map` if data showed up past its end.
+ *
+ * Only `RDRAM_HEAP_PROBE_LENGTH` bytes after `map->limit` are looked at (more
+ * only if those are in use as well), which is cheap enough to do every frame.
+ * The heap grows upwards into the headroom left by `rdram_region_map_build()`,
+ * so new data beyond the map only goes unnoticed if all of those bytes are
+ * still zero.
+ *
+ * @return `true` if `map` was extended.
+ */
+static inline bool rdram_region_map_extend(
+		RDRAMRegionMap *restrict const map,
+		const u8 *restrict const raw_data,
+		const size_t capacity
+) {
+	size_t high_water_mark = 0ULL;
+	for (size_t start = map->limit; start < capacity; start += RDRAM_HEAP_PROBE_LENGTH) {
+		const size_t length = ((capacity - start) < RDRAM_HEAP_PROBE_LENGTH) ? (capacity - start) : RDRAM_HEAP_PROBE_LENGTH;
+		const size_t occupied_length = rdram_find_occupied_length(raw_data + start, length);
+		if (occupied_length == 0ULL) {
+			break;
+		}
+
+		high_water_mark = start + occupied_length;
+	}
+
+	if (high_water_mark == 0ULL) {
+		return false;
+	}
+
+	const size_t heap_end = rdram_region_map_get_heap_end(high_water_mark, capacity);
+	RDRAMRegion *last = (map->count > 0ULL) ? &(map->regions[map->count - 1ULL]) : NULL;
+	if ((last != NULL) && (strcmp(last->name, "heap") == 0)) {
+		last->end = heap_end;
+		map->limit = heap_end;
+	} else {
+		rdram_region_map_push(map, "heap", map->limit, heap_end);
+	}
+
+	return true;
+}
+
+/**
+ * @brief Clamp a length (or end address) so it does not reach beyond the last
+ *        region in use.
+ */
+static inline size_t rdram_region_map_clamp(const RDRAMRegionMap *restrict const map, const size_t length) {
+	return (length < map->limit) ? length : map->limit;
+}
+
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__SCAN_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__SCAN_H_ 1
+
+#include <stddef.h>
+#include <string.h>
+
+#include "./cpu.h"
+#include "./types.h"
+
+#if CPU_ARCH_X86
+#include <immintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A kernel that finds the end of the last non-zero byte in `data`.
+ * @param[in] data The buffer to scan. May be unaligned.
+ * @param[in] size The size of `data` in bytes.
+ * @return The offset one past the last non-zero byte, or `0` if every byte of
+ *         `data` is zero.
+ */
+typedef size_t (*ScanKernel)(const u8 *data, size_t size);
+
+/**
+ * @brief Narrow down a block that is known to contain a non-zero byte (or the
+ *        unaligned rest of a buffer) one byte at a time.
+ */
+static inline size_t scan_nonzero_tail_bytewise(const u8 *data, size_t end) {
+	while ((end > 0ULL) && (data[end - 1ULL] == 0)) {
+		end--;
+	}
+
+	return end;
+}
+
+static inline size_t scan_nonzero_tail_scalar(const u8 *data, size_t size) {
+	size_t end = size;
+
+	for (; (end & 63ULL) != 0ULL; end--) {
+		if (data[end - 1ULL] != 0) return end;
+	}
+
+	for (; end >= 64ULL; end -= 64ULL) {
+		u64 block[8];
+		memcpy(block, data + end - 64ULL, sizeof(block));
+
+		u64 combined = 0ULL;
+		for (size_t i = 0ULL; i < 8ULL; i++) {
+			combined |= block[i];
+		}
+
+		if (combined != 0ULL) break;
+	}
+
+	return scan_nonzero_tail_bytewise(data, end);
+}
+
+#if CPU_ARCH_X86
+
+__attribute__((__target__("sse2")))
+static inline size_t scan_nonzero_tail_sse2(const u8 *data, size_t size) {
+	size_t end = size;
+
+	for (; (end & 63ULL) != 0ULL; end--) {
+		if (data[end - 1ULL] != 0) return end;
+	}
+
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; end >= 64ULL; end -= 64ULL) {
+		const u8 *block = data + end - 64ULL;
+		__m128i combined = _mm_or_si128(
+			_mm_or_si128(
+				_mm_loadu_si128((const __m128i *)(block +  0ULL)),
+				_mm_loadu_si128((const __m128i *)(block + 16ULL))
+			),
+			_mm_or_si128(
+				_mm_loadu_si128((const __m128i *)(block + 32ULL)),
+				_mm_loadu_si128((const __m128i *)(block + 48ULL))
+			)
+		);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(combined, zero)) != 0xFFFF) break;
+	}
+
+	return scan_nonzero_tail_bytewise(data, end);
+}
+
+__attribute__((__target__("avx2")))
+static inline size_t scan_nonzero_tail_avx2(const u8 *data, size_t size) {
+	size_t end = size;
+
+	for (; (end & 63ULL) != 0ULL; end--) {
+		if (data[end - 1ULL] != 0) return end;
+	}
+
+	for (; end >= 64ULL; end -= 64ULL) {
+		const u8 *block = data + end - 64ULL;
+		__m256i combined = _mm256_or_si256(
+			_mm256_loadu_si256((const __m256i *)(block +  0ULL)),
+			_mm256_loadu_si256((const __m256i *)(block + 32ULL))
+		);
+
+		if (!_mm256_testz_si256(combined, combined)) break;
+	}
+
+	return scan_nonzero_tail_bytewise(data, end);
+}
+
+#endif
+
+/**
+ * @brief Find the end of the last non-zero byte in a host buffer, checking 64
+ *        bytes per step.
+ */
+static ScanKernel scan_nonzero_tail = scan_nonzero_tail_scalar;
+
+__attribute__((__constructor__))
+static inline void scan_select_kernels(void) {
+#if CPU_ARCH_X86
+	const CPUFeatures features = cpu_get_features();
+
+	if (features & CPUFeatures_AVX2) {
+		scan_nonzero_tail = scan_nonzero_tail_avx2;
+	} else if (features & CPUFeatures_SSE2) {
+		scan_nonzero_tail = scan_nonzero_tail_sse2;
+	}
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Compute the occupied length of RDRAM, i.e. the N64 address one past
+ *        the last non-zero byte.
+ *
+ * Since whether a word is zero does not depend on its byte order, the scan
+ * runs over the raw host memory. Only the last non-zero word needs to be
+ * looked at in N64 byte order to find the exact end.
+ *
+ * @param[in] raw_data The recomp's view of N64 memory.
+ * @param[in] capacity The number of bytes in `raw_data` that may be scanned.
+ * @return The occupied length in bytes, or `0` if all of RDRAM is zero.
+ */
+static inline size_t rdram_find_occupied_length(const u8 *restrict const raw_data, const size_t capacity) {
+	const size_t host_end = scan_nonzero_tail(raw_data, capacity);
+	if (host_end == 0ULL) {
+		return 0ULL;
+	}
+
+	const size_t word_address = (host_end - 1ULL) & ~(size_t)3ULL;
+	for (size_t i = 4ULL; i > 0ULL; i--) {
+		const size_t host_index = word_address + ((i - 1ULL) ^ 3ULL);
+		if ((host_index < capacity) && (raw_data[host_index] != 0)) {
+			return word_address + i;
+		}
+	}
+
+	return host_end;
+}
+
+#endif
@@ -0,0 +1,311 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__SCRIPT_ARCHIVE_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__SCRIPT_ARCHIVE_H_ 1
+
+/**
+ * Read-only archives of Lua modules (as written by `pack_scripts.lua` in the
+ * root of this repository), so that `require()` can find a module with a
+ * single binary search in a memory-mapped file instead of probing every
+ * entry of `package.path` on disk.
+ *
+ * All integers are little-endian. An archive starts with a header:
+ *
+ * | Offset | Size | Description                               |
+ * |--------|------|-------------------------------------------|
+ * | 0      | 8    | Magic bytes `"LuaLPAK\0"`                 |
+ * | 8      | 4    | Format version (`SCRIPT_ARCHIVE_VERSION`) |
+ * | 12     | 4    | Number of entries                         |
+ *
+ * It is followed by the index, one `ScriptArchiveEntry` per module, sorted by
+ * module name (compared bytewise). The names, sources and bytecode that the
+ * entries point to can be anywhere in the file after that. Every entry holds
+ * the source of its module, precompiled bytecode, or both; bytecode is
+ * preferred, and the source serves as a fallback for when it was compiled by
+ * an incompatible version of Lua. Like any Lua bytecode, it is not verified,
+ * so archives must come from a trusted source.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../lua/src/lua.h"
+#include "../lua/src/lualib.h"
+#include "../lua/src/lauxlib.h"
+
+#include "./types.h"
+
+#define SCRIPT_ARCHIVE_VERSION 1U
+
+#define SCRIPT_ARCHIVE_HEADER_SIZE 16ULL
+
+#define ScriptArchive__name "LuaLoader::ScriptArchive"
+
+static const char script_archive_magic[8] = { 'L', 'u', 'a', 'L', 'P', 'A', 'K', '\0' };
+
+typedef struct ScriptArchiveEntry {
+	u32 name_offset;
+	u32 name_length;
+	u32 source_offset;
+	u32 source_length;
+	u32 bytecode_offset;
+	u32 bytecode_length;
+} ScriptArchiveEntry;
+
+typedef struct ScriptArchive {
+	const u8 *data; // mapped with `mmap()`, or `NULL` once unmapped
+	size_t size;
+	u32 entry_count;
+} ScriptArchive;
+
+static inline u32 script_archive_load_u32(const u8 *ptr) {
+	return (u32)ptr[0] | ((u32)ptr[1] << 8) | ((u32)ptr[2] << 16) | ((u32)ptr[3] << 24);
+}
+
+static inline ScriptArchiveEntry script_archive_get_entry(const ScriptArchive *restrict const archive, const u32 i) {
+	const u8 *ptr = archive->data + SCRIPT_ARCHIVE_HEADER_SIZE + ((size_t)i * (6ULL * sizeof(u32)));
+
+	return (ScriptArchiveEntry){
+		.name_offset     = script_archive_load_u32(ptr +  0),
+		.name_length     = script_archive_load_u32(ptr +  4),
+		.source_offset   = script_archive_load_u32(ptr +  8),
+		.source_length   = script_archive_load_u32(ptr + 12),
+		.bytecode_offset = script_archive_load_u32(ptr + 16),
+		.bytecode_length = script_archive_load_u32(ptr + 20),
+	};
+}
+
+static inline bool script_archive_range_is_valid(const ScriptArchive *restrict const archive, const u32 offset, const u32 length) {
+	return ((u64)offset + (u64)length) <= (u64)(archive->size);
+}
+
+static inline int script_archive_compare_names(const u8 *a, const size_t a_length, const u8 *b, const size_t b_length) {
+	const int result = memcmp(a, b, (a_length < b_length) ? a_length : b_length);
+	if (result != 0) {
+		return result;
+	}
+
+	return (a_length > b_length) - (a_length < b_length);
+}
+
+/**
+ * @brief Check the header and every entry of `archive`, so that lookups do
+ *        not have to.
+ * @return `NULL` on success, or a description of what is wrong.
+ */
+static inline const char *script_archive_validate(ScriptArchive *restrict const archive) {
+	if ((archive->size < SCRIPT_ARCHIVE_HEADER_SIZE) || (memcmp(archive->data, script_archive_magic, sizeof(script_archive_magic)) != 0)) {
+		return "not a script archive";
+	}
+
+	if (script_archive_load_u32(archive->data + 8) != SCRIPT_ARCHIVE_VERSION) {
+		return "unsupported script archive version";
+	}
+
+	archive->entry_count = script_archive_load_u32(archive->data + 12);
+	const u64 index_size = (u64)(archive->entry_count) * (6ULL * sizeof(u32));
+	if ((SCRIPT_ARCHIVE_HEADER_SIZE + index_size) > (u64)(archive->size)) {
+		return "index out of bounds";
+	}
+
+	for (u32 i = 0; i < archive->entry_count; i++) {
+		const ScriptArchiveEntry entry = script_archive_get_entry(archive, i);
+		if (
+			!script_archive_range_is_valid(archive, entry.name_offset, entry.name_length) ||
+			!script_archive_range_is_valid(archive, entry.source_offset, entry.source_length) ||
+			!script_archive_range_is_valid(archive, entry.bytecode_offset, entry.bytecode_length)
+		) {
+			return "entry out of bounds";
+		}
+
+		if (i == 0) {
+			continue;
+		}
+
+		const ScriptArchiveEntry previous = script_archive_get_entry(archive, i - 1);
+		if (script_archive_compare_names(
+			archive->data + previous.name_offset, previous.name_length,
+			archive->data + entry.name_offset, entry.name_length
+		) >= 0) {
+			return "index is not sorted";
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Find the entry of the module `name` with a binary search.
+ * @return `false` if there is none.
+ */
+static inline bool script_archive_find(
+		const ScriptArchive *restrict const archive,
+		const char *restrict const name,
+		const size_t name_length,
+		ScriptArchiveEntry *restrict const out_entry
+) {
+	u32 low = 0;
+	u32 high = archive->entry_count;
+
+	while (low < high) {
+		const u32 middle = low + ((high - low) / 2);
+		const ScriptArchiveEntry entry = script_archive_get_entry(archive, middle);
+		const int result = script_archive_compare_names(
+			archive->data + entry.name_offset, entry.name_length,
+			(const u8 *)name, name_length
+		);
+
+		if (result == 0) {
+			*out_entry = entry;
+			return true;
+		}
+
+		if (result < 0) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	return false;
+}
+
+static inline void script_archive_unmap(ScriptArchive *restrict const archive) {
+	if (archive->data != NULL) {
+		munmap((void *)(archive->data), archive->size);
+		archive->data = NULL;
+	}
+}
+
+static inline int script_archive_gc(lua_State *L) {
+	script_archive_unmap((ScriptArchive *)luaL_checkudata(L, 1, ScriptArchive__name));
+	return 0;
+}
+
+/**
+ * @brief The `package.searchers` entry for one archive, which is its first
+ *        upvalue. The archive path is the second one.
+ */
+static inline int script_archive_searcher(lua_State *L) {
+	size_t name_length = 0ULL;
+	const char *name = luaL_checklstring(L, 1, &name_length);
+	const ScriptArchive *archive = (const ScriptArchive *)lua_touserdata(L, lua_upvalueindex(1));
+	const char *archive_path = lua_tostring(L, lua_upvalueindex(2));
+
+	ScriptArchiveEntry entry;
+	if ((archive->data == NULL) || !script_archive_find(archive, name, name_length, &entry)) {
+		lua_pushfstring(L, "no module '%s' in archive '%s'", name, archive_path);
+		return 1;
+	}
+
+	const char *chunk_name = lua_pushfstring(L, "@%s(%s)", archive_path, name);
+
+	int status = LUA_ERRSYNTAX;
+	if (entry.bytecode_length > 0) {
+		status = luaL_loadbufferx(
+			L,
+			(const char *)(archive->data + entry.bytecode_offset),
+			entry.bytecode_length,
+			chunk_name,
+			"b"
+		);
+
+		if ((status != LUA_OK) && (entry.source_length > 0)) {
+			lua_pop(L, 1);
+		}
+	}
+
+	if ((status != LUA_OK) && (entry.source_length > 0)) {
+		status = luaL_loadbufferx(
+			L,
+			(const char *)(archive->data + entry.source_offset),
+			entry.source_length,
+			chunk_name,
+			"t"
+		);
+	}
+
+	if (status != LUA_OK) {
+		return luaL_error(
+			L,
+			"error loading module '%s' from archive '%s':\n\t%s",
+			name,
+			archive_path,
+			(entry.bytecode_length + entry.source_length > 0) ? lua_tostring(L, -1) : "empty entry"
+		);
+	}
+
+	lua_pushvalue(L, lua_upvalueindex(2));
+
+	return 2;
+}
+
+/**
+ * @brief Map the archive at `archive_path` and put a searcher for it into
+ *        `package.searchers`, right before the one for files on disk. The
+ *        archive stays mapped until the searcher gets garbage-collected.
+ * @return `NULL` on success, or a description of what went wrong.
+ */
+static inline const char *script_archive_mount(lua_State *L, const char *archive_path) {
+	const int fd = open(archive_path, O_RDONLY);
+	if (fd < 0) {
+		return "cannot open archive";
+	}
+
+	struct stat file_info;
+	if ((fstat(fd, &file_info) != 0) || (file_info.st_size <= 0)) {
+		close(fd);
+		return "cannot determine the size of the archive";
+	}
+
+	void *data = mmap(NULL, (size_t)(file_info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return "cannot map archive into memory";
+	}
+
+	ScriptArchive *archive = (ScriptArchive *)lua_newuserdatauv(L, sizeof(ScriptArchive), 0);
+	*archive = (ScriptArchive){ .data = (const u8 *)data, .size = (size_t)(file_info.st_size) };
+	if (luaL_newmetatable(L, ScriptArchive__name)) {
+		lua_pushcfunction(L, script_archive_gc);
+		lua_setfield(L, -2, "__gc");
+	}
+	lua_setmetatable(L, -2);
+
+	const char *error_message = script_archive_validate(archive);
+	if (error_message != NULL) {
+		script_archive_unmap(archive);
+		lua_pop(L, 1);
+		return error_message;
+	}
+
+	lua_pushstring(L, archive_path);
+	lua_pushcclosure(L, script_archive_searcher, 2);
+
+	lua_getglobal(L, LUA_LOADLIBNAME);
+	if (lua_getfield(L, -1, "searchers") != LUA_TTABLE) {
+		lua_pop(L, 3);
+		return "`package.searchers` is not a table";
+	}
+
+	// Shift every searcher from the second one on back by one.
+	lua_Integer i = (lua_Integer)luaL_len(L, -1);
+	for (; i >= 2; i--) {
+		lua_rawgeti(L, -1, i);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_rotate(L, -3, -1);
+	lua_rawseti(L, -2, 2);
+	lua_pop(L, 2);
+
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,551 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__SNAPSHOT_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__SNAPSHOT_H_ 1
+
+/**
+ * A compressed, randomly accessible container for RDRAM snapshots.
+ *
+ * Memory is split into pages of `SNAPSHOT_PAGE_SIZE` bytes, each of which is
+ * stored in the recomp's raw layout. A file consists of:
+ *
+ * 1. A `SnapshotHeader`.
+ * 2. For delta snapshots (`SNAPSHOT_FLAG_DELTA`), the path of the base
+ *    snapshot, without a terminating NUL. Relative paths are relative to the
+ *    directory of the delta snapshot.
+ * 3. The stored pages. All-zero pages are left out entirely, pages that are
+ *    identical to an earlier one are only stored once and the rest is
+ *    compressed with the codec from `utils/lz.h` (or stored as-is if that does
+ *    not make them any smaller).
+ * 4. An index of `SnapshotPageEntry`s, which allows reading any single page
+ *    without touching the rest of the file. Full snapshots have one entry for
+ *    every page. Delta snapshots only have entries for the pages that changed
+ *    since their base, followed by a sorted array of `u32` page numbers that
+ *    says which entry belongs to which page.
+ *
+ * The base of a delta may itself be a delta, so loading a delta means
+ * following the whole chain of bases down to a full snapshot, see
+ * `snapshot_chain_find_page()`.
+ *
+ * All integers are stored in host byte order.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./hash.h"
+#include "./lz.h"
+#include "./scan.h"
+#include "./types.h"
+
+#define SNAPSHOT_MAGIC     "LLRDSNAP"
+#define SNAPSHOT_VERSION   2U
+#define SNAPSHOT_PAGE_SIZE 0x1000ULL
+
+#define SNAPSHOT_FLAG_DELTA 0x00000001U
+
+// Every snapshot in a chain stays memory-mapped while it is in use, and finding
+// a page means walking the chain from the newest snapshot down, so chains are
+// cut short by a full snapshot once they reach this length (at 60 deltas per
+// second, about every half second). This also catches snapshots that (directly
+// or indirectly) refer to themselves. Can be overridden at build time.
+#ifndef SNAPSHOT_MAX_CHAIN_LENGTH
+#define SNAPSHOT_MAX_CHAIN_LENGTH 32ULL
+#endif
+
+typedef struct SnapshotHeader {
+	char magic[8];
+	u32 version;
+	u32 page_size;
+	u64 capacity;
+	u64 page_count;
+	u64 entry_count;
+	u64 index_offset;
+	u64 id; // see `snapshot_compute_id()`
+	u64 base_id; // `id` of the base snapshot, only used by deltas
+	u32 flags;
+	u32 base_path_length;
+} SnapshotHeader;
+
+typedef enum SnapshotPageKind {
+	SnapshotPageKind_Zero = 0U,
+	SnapshotPageKind_Raw  = 1U,
+	SnapshotPageKind_LZ   = 2U,
+} SnapshotPageKind;
+
+typedef struct SnapshotPageEntry {
+	u64 offset;
+	u64 hash; // `hash_bytes()` of the uncompressed page
+	u32 stored_size;
+	u32 kind; // `SnapshotPageKind`
+} SnapshotPageEntry;
+
+_Static_assert((sizeof(SnapshotHeader) == 72ULL), "");
+_Static_assert((sizeof(SnapshotPageEntry) == 24ULL), "");
+
+static inline size_t snapshot_page_length(const size_t capacity, const size_t page) {
+	const size_t start = page * SNAPSHOT_PAGE_SIZE;
+	return ((capacity - start) < SNAPSHOT_PAGE_SIZE) ? (capacity - start) : SNAPSHOT_PAGE_SIZE;
+}
+
+static inline bool snapshot_is_snapshot(const u8 *restrict const file_data, const size_t file_size) {
+	return (file_size >= sizeof(SnapshotHeader)) && (memcmp(file_data, SNAPSHOT_MAGIC, 8ULL) == 0);
+}
+
+/**
+ * @brief Identify a snapshot by the hashes of all of its pages, so that a
+ *        delta can tell whether it is being loaded on top of the right base.
+ */
+static inline u64 snapshot_compute_id(const u64 *restrict const page_hashes, const size_t page_count) {
+	return hash_bytes((const u8 *)page_hashes, page_count * sizeof(u64), 0ULL);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The snapshot a delta snapshot is written against. Only the hashes of its
+ * pages are needed, not the pages themselves.
+ */
+typedef struct SnapshotBase {
+	const char *path; // as it should be stored in the delta snapshot
+	const u64 *page_hashes;
+	size_t page_count;
+} SnapshotBase;
+
+/**
+ * @brief Write the first `capacity` bytes of `raw_data` to `file` as a
+ *        snapshot.
+ *
+ * Pages are compared with their base by hash alone, so a hash collision would
+ * cause a changed page to be missed. With 64-bit hashes, that is a risk worth
+ * taking in exchange for not having to keep the base in memory.
+ *
+ * @param[in] file The file to write to.
+ * @param[in] raw_data The recomp's view of N64 memory.
+ * @param[in] capacity The number of bytes in `raw_data` to write.
+ * @param[in] base The snapshot to write a delta against, or `NULL` to write a
+ *                 full snapshot.
+ * @param[out] out_page_hashes If not `NULL`, receives the hash of each page,
+ *                             so that the snapshot can serve as the base of
+ *                             the next one.
+ * @return `true` on success, `false` if allocating memory or writing to
+ *         `file` failed.
+ */
+static inline bool snapshot_write(
+		FILE *restrict const file,
+		const u8 *restrict const raw_data,
+		const size_t capacity,
+		const SnapshotBase *restrict const base,
+		u64 *restrict const out_page_hashes
+) {
+	const size_t page_count = (capacity + SNAPSHOT_PAGE_SIZE - 1ULL) / SNAPSHOT_PAGE_SIZE;
+
+	// Maps page hashes to the (1-based) number of the first page with that
+	// hash, so that repeated pages only need to be stored once.
+	size_t dedup_capacity = 16ULL;
+	while (dedup_capacity < (page_count * 2ULL)) dedup_capacity *= 2ULL;
+
+	SnapshotPageEntry *entries = (SnapshotPageEntry *)calloc(page_count + 1ULL, sizeof(SnapshotPageEntry));
+	u64 *page_hashes = (u64 *)calloc(page_count + 1ULL, sizeof(u64));
+	u32 *listed_pages = (u32 *)calloc(page_count + 1ULL, sizeof(u32));
+	size_t *dedup = (size_t *)calloc(dedup_capacity, sizeof(size_t));
+	u8 *compressed = (u8 *)malloc(SNAPSHOT_PAGE_SIZE);
+
+	bool success = (
+		(entries != NULL) &&
+		(page_hashes != NULL) &&
+		(listed_pages != NULL) &&
+		(dedup != NULL) &&
+		(compressed != NULL)
+	);
+
+	SnapshotHeader header = { 0 };
+	memcpy(header.magic, SNAPSHOT_MAGIC, 8ULL);
+	header.version = SNAPSHOT_VERSION;
+	header.page_size = (u32)SNAPSHOT_PAGE_SIZE;
+	header.capacity = (u64)capacity;
+	header.page_count = (u64)page_count;
+
+	if (base != NULL) {
+		header.flags |= SNAPSHOT_FLAG_DELTA;
+		header.base_id = snapshot_compute_id(base->page_hashes, base->page_count);
+		header.base_path_length = (u32)strlen(base->path);
+	}
+
+	success = success && (fwrite(&header, sizeof(header), 1ULL, file) == 1ULL);
+	success = success && (
+		(base == NULL) ||
+		(fwrite(base->path, sizeof(char), header.base_path_length, file) == header.base_path_length)
+	);
+	u64 offset = (u64)sizeof(header) + header.base_path_length;
+	size_t entry_count = 0ULL;
+
+	for (size_t page = 0ULL; success && (page < page_count); page++) {
+		const u8 *data = raw_data + (page * SNAPSHOT_PAGE_SIZE);
+		const size_t length = snapshot_page_length(capacity, page);
+		SnapshotPageEntry *entry = &(entries[page]);
+
+		entry->hash = hash_bytes(data, length, 0ULL);
+		page_hashes[page] = entry->hash;
+
+		// The hash covers the page length, so a partial page at the end never
+		// matches a full one in a larger base.
+		if ((base != NULL) && (page < base->page_count) && (base->page_hashes[page] == entry->hash)) {
+			continue;
+		}
+
+		listed_pages[entry_count++] = (u32)page;
+
+		if (scan_nonzero_tail(data, length) == 0ULL) {
+			entry->kind = SnapshotPageKind_Zero;
+			continue;
+		}
+
+		size_t slot = (size_t)(entry->hash & (dedup_capacity - 1ULL));
+		bool is_duplicate = false;
+		for (; dedup[slot] != 0ULL; slot = (slot + 1ULL) & (dedup_capacity - 1ULL)) {
+			const size_t other_page = dedup[slot] - 1ULL;
+			if (
+				(entries[other_page].hash == entry->hash) &&
+				(snapshot_page_length(capacity, other_page) == length) &&
+				(memcmp(raw_data + (other_page * SNAPSHOT_PAGE_SIZE), data, length) == 0)
+			) {
+				*entry = entries[other_page];
+				is_duplicate = true;
+				break;
+			}
+		}
+
+		if (is_duplicate) {
+			continue;
+		}
+
+		dedup[slot] = page + 1ULL;
+
+		const size_t compressed_size = lz_compress(data, length, compressed, length - 1ULL);
+		const u8 *stored = (compressed_size != 0ULL) ? compressed : data;
+
+		entry->offset = offset;
+		entry->kind = (compressed_size != 0ULL) ? SnapshotPageKind_LZ : SnapshotPageKind_Raw;
+		entry->stored_size = (u32)((compressed_size != 0ULL) ? compressed_size : length);
+
+		success = fwrite(stored, sizeof(u8), entry->stored_size, file) == entry->stored_size;
+		offset += entry->stored_size;
+	}
+
+	// Keep the index 8-byte aligned, so it can be used in place once the file
+	// has been memory-mapped.
+	const u8 padding[8] = { 0 };
+	const size_t padding_length = (size_t)((8ULL - (offset & 7ULL)) & 7ULL);
+	success = success && (fwrite(padding, sizeof(u8), padding_length, file) == padding_length);
+	offset += padding_length;
+
+	header.entry_count = (u64)entry_count;
+	header.index_offset = offset;
+
+	for (size_t i = 0ULL; success && (i < entry_count); i++) {
+		success = fwrite(&(entries[listed_pages[i]]), sizeof(SnapshotPageEntry), 1ULL, file) == 1ULL;
+	}
+
+	success = success && (
+		(base == NULL) ||
+		(fwrite(listed_pages, sizeof(u32), entry_count, file) == entry_count)
+	);
+
+	if (success) {
+		header.id = snapshot_compute_id(page_hashes, page_count);
+		if (out_page_hashes != NULL) {
+			memcpy(out_page_hashes, page_hashes, page_count * sizeof(u64));
+		}
+	}
+
+	success = success && (fseek(file, 0L, SEEK_SET) == 0);
+	success = success && (fwrite(&header, sizeof(header), 1ULL, file) == 1ULL);
+
+	free(entries);
+	free(page_hashes);
+	free(listed_pages);
+	free(dedup);
+	free(compressed);
+
+	return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct SnapshotReader {
+	const u8 *file_data;
+	size_t file_size;
+	const SnapshotHeader *header;
+	const SnapshotPageEntry *index;
+	const u32 *listed_pages; // `NULL` unless this is a delta
+	const char *base_path; // not NUL-terminated, `NULL` unless this is a delta
+	size_t base_path_length;
+} SnapshotReader;
+
+/**
+ * @brief Validate the snapshot in `file_data` and prepare it for reading.
+ *
+ * Every page entry gets checked here, so that reading a page later on can
+ * never touch anything outside of `file_data`.
+ *
+ * @param[out] reader The reader to initialize.
+ * @param[in] file_data The contents of the snapshot file, at least 8-byte
+ *                      aligned (which memory-mapped files always are).
+ * @param[in] file_size The size of `file_data` in bytes.
+ * @return `NULL` on success, or a description of what is wrong with the file.
+ */
+static inline const char *snapshot_reader_init(
+		SnapshotReader *restrict const reader,
+		const u8 *restrict const file_data,
+		const size_t file_size
+) {
+	*reader = (SnapshotReader){ 0 };
+
+	if (!snapshot_is_snapshot(file_data, file_size)) {
+		return "not a snapshot";
+	}
+
+	const SnapshotHeader *header = (const SnapshotHeader *)file_data;
+	if (header->version != SNAPSHOT_VERSION) {
+		return "unsupported snapshot version";
+	}
+
+	if (header->page_size != SNAPSHOT_PAGE_SIZE) {
+		return "unsupported page size";
+	}
+
+	if (
+		(header->capacity == 0ULL) ||
+		(header->page_count != ((header->capacity + SNAPSHOT_PAGE_SIZE - 1ULL) / SNAPSHOT_PAGE_SIZE)) ||
+		(header->page_count > UINT32_MAX)
+	) {
+		return "invalid capacity or page count";
+	}
+
+	const bool is_delta = (header->flags & SNAPSHOT_FLAG_DELTA) != 0U;
+	if (
+		((header->flags & ~SNAPSHOT_FLAG_DELTA) != 0U) ||
+		(is_delta != (header->base_path_length != 0U)) ||
+		(header->base_path_length > (file_size - sizeof(SnapshotHeader)))
+	) {
+		return "invalid flags or base path";
+	}
+
+	if (is_delta ? (header->entry_count > header->page_count) : (header->entry_count != header->page_count)) {
+		return "invalid entry count";
+	}
+
+	const size_t index_size = (size_t)(header->entry_count) * (
+		sizeof(SnapshotPageEntry) + (is_delta ? sizeof(u32) : 0ULL)
+	);
+
+	if (
+		((header->index_offset & 7ULL) != 0ULL) ||
+		(header->index_offset > file_size) ||
+		(index_size > (file_size - header->index_offset))
+	) {
+		return "truncated page index";
+	}
+
+	const SnapshotPageEntry *index = (const SnapshotPageEntry *)(file_data + header->index_offset);
+	const u32 *listed_pages = is_delta ? (const u32 *)(index + header->entry_count) : NULL;
+
+	for (size_t i = 0ULL; i < header->entry_count; i++) {
+		const SnapshotPageEntry *entry = &(index[i]);
+
+		size_t page = i;
+		if (is_delta) {
+			page = (size_t)listed_pages[i];
+			if ((page >= header->page_count) || ((i > 0ULL) && (page <= listed_pages[i - 1ULL]))) {
+				return "invalid page numbers";
+			}
+		}
+
+		const size_t length = snapshot_page_length(header->capacity, page);
+
+		switch (entry->kind) {
+			case SnapshotPageKind_Zero: {
+				continue;
+			}
+			case SnapshotPageKind_Raw: {
+				if (entry->stored_size != length) return "invalid raw page size";
+				break;
+			}
+			case SnapshotPageKind_LZ: {
+				if (entry->stored_size > length) return "invalid compressed page size";
+				break;
+			}
+			default: {
+				return "invalid page kind";
+			}
+		}
+
+		if ((entry->offset > file_size) || (entry->stored_size > (file_size - entry->offset))) {
+			return "page data out of bounds";
+		}
+	}
+
+	reader->file_data = file_data;
+	reader->file_size = file_size;
+	reader->header = header;
+	reader->index = index;
+	reader->listed_pages = listed_pages;
+
+	if (is_delta) {
+		reader->base_path = (const char *)(file_data + sizeof(SnapshotHeader));
+		reader->base_path_length = (size_t)(header->base_path_length);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Look up the index entry of `page`.
+ * @return The entry, or `NULL` if `page` is out of range or, for deltas, has
+ *         not changed since the base snapshot.
+ */
+static inline const SnapshotPageEntry *snapshot_reader_find_entry(const SnapshotReader *restrict const reader, const size_t page) {
+	if (page >= reader->header->page_count) {
+		return NULL;
+	}
+
+	if (reader->listed_pages == NULL) {
+		return &(reader->index[page]);
+	}
+
+	size_t low = 0ULL;
+	size_t high = (size_t)(reader->header->entry_count);
+	while (low < high) {
+		const size_t middle = low + ((high - low) / 2ULL);
+		if (reader->listed_pages[middle] < page) {
+			low = middle + 1ULL;
+		} else {
+			high = middle;
+		}
+	}
+
+	if ((low < reader->header->entry_count) && (reader->listed_pages[low] == page)) {
+		return &(reader->index[low]);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Decompress a single page into `dst`, which must have room for
+ *        `SNAPSHOT_PAGE_SIZE` bytes.
+ * @return `false` if the page data turned out to be corrupt, or if the page
+ *         lives in the base snapshot.
+ */
+static inline bool snapshot_reader_read_page(const SnapshotReader *restrict const reader, const size_t page, u8 *restrict const dst) {
+	const SnapshotPageEntry *entry = snapshot_reader_find_entry(reader, page);
+	if (entry == NULL) {
+		return false;
+	}
+
+	const size_t length = snapshot_page_length(reader->header->capacity, page);
+
+	// Zero pages have no meaningful offset.
+	switch (entry->kind) {
+		case SnapshotPageKind_Zero: {
+			memset(dst, 0, length);
+			return true;
+		}
+		case SnapshotPageKind_Raw: {
+			memcpy(dst, reader->file_data + entry->offset, length);
+			return true;
+		}
+		case SnapshotPageKind_LZ: {
+			return lz_decompress(reader->file_data + entry->offset, entry->stored_size, dst, length);
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Check that a chain of snapshots fits together, so that every page of
+ *        the newest one can be resolved.
+ * @param[in] chain The snapshots, starting with the newest one. Each one must
+ *                  be the base of the one before it.
+ * @param[in] chain_length The number of snapshots in `chain`.
+ * @return `NULL` on success, or a description of what is wrong with the chain.
+ */
+static inline const char *snapshot_chain_validate(const SnapshotReader *restrict const chain, const size_t chain_length) {
+	if ((chain_length == 0ULL) || (chain[chain_length - 1ULL].base_path != NULL)) {
+		return "incomplete snapshot chain";
+	}
+
+	for (size_t i = 0ULL; (i + 1ULL) < chain_length; i++) {
+		const SnapshotHeader *header = chain[i].header;
+		const SnapshotHeader *base_header = chain[i + 1ULL].header;
+
+		if (header->base_id != base_header->id) {
+			return "snapshot does not match its base";
+		}
+
+		// Pages the base has fewer bytes of must have been written out. An
+		// unchanged partial page at the end of both is left to the base.
+		const size_t first_page = (base_header->capacity / SNAPSHOT_PAGE_SIZE);
+		for (size_t page = first_page; page < header->page_count; page++) {
+			const bool base_has_page = (page < base_header->page_count) && (
+				snapshot_page_length(base_header->capacity, page) == snapshot_page_length(header->capacity, page)
+			);
+
+			if (!base_has_page && (snapshot_reader_find_entry(&(chain[i]), page) == NULL)) {
+				return "snapshot does not match its base";
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Find the snapshot in a (validated) chain that actually holds `page`.
+ * @return The reader to pass to `snapshot_reader_read_page()`, or `NULL` if
+ *         `page` lies beyond the end of the newest snapshot.
+ */
+static inline const SnapshotReader *snapshot_chain_find_page(
+		const SnapshotReader *restrict const chain,
+		const size_t chain_length,
+		const size_t page
+) {
+	if (page >= chain[0].header->page_count) {
+		return NULL;
+	}
+
+	for (size_t i = 0ULL; i < chain_length; i++) {
+		if (snapshot_reader_find_entry(&(chain[i]), page) != NULL) {
+			return &(chain[i]);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Count the pages of the newest snapshot in a chain up to and
+ *        including the last one that is not all zeros.
+ */
+static inline size_t snapshot_chain_occupied_page_count(const SnapshotReader *restrict const chain, const size_t chain_length) {
+	size_t page_count = (size_t)(chain[0].header->page_count);
+	while (page_count > 0ULL) {
+		const SnapshotReader *reader = snapshot_chain_find_page(chain, chain_length, page_count - 1ULL);
+		if ((reader != NULL) && (snapshot_reader_find_entry(reader, page_count - 1ULL)->kind != SnapshotPageKind_Zero)) {
+			break;
+		}
+
+		page_count--;
+	}
+
+	return page_count;
+}
+
+#endif
@@ -0,0 +1,505 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__SWIZZLE_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__SWIZZLE_H_ 1
+
+/**
+ * Conversion kernels between the recomp's RDRAM layout and host memory.
+ *
+ * The recomp stores N64 memory as an array of native (little-endian) 32-bit
+ * words. A single byte at the N64 address `a` is thus found at `a ^ 3`, an
+ * aligned halfword at `a ^ 2`, an aligned word directly at `a` and a
+ * doubleword is split into its high word at `a` and its low word at `a + 4`.
+ *
+ * All addresses taken by the functions below are 0-based offsets into RDRAM
+ * that have already been masked with `0x7FFFFFFF`.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "./cpu.h"
+#include "./types.h"
+
+#if CPU_ARCH_X86
+#include <immintrin.h>
+#endif
+
+// The amount of memory reserved by the recomp. Operations that touch all of
+// memory at once should be bounded by `rdram_get_regions()` instead.
+#define RDRAM_LENGTH 0x20000000ULL
+_Static_assert((RDRAM_LENGTH >= 4ULL), "");
+
+////////////////////////////////////////////////////////////////////////////////
+
+static inline u8 rdram_load_u8(const u8 *restrict const raw_data, const u64 address) {
+	return raw_data[(address & 0x7FFFFFFFULL) ^ 3ULL];
+}
+
+static inline u16 rdram_load_u16(const u8 *restrict const raw_data, const u64 address) {
+	if ((address & 1ULL) == 0ULL) {
+		return *(const u16 *)(raw_data + ((address & 0x7FFFFFFFULL) ^ 2ULL));
+	}
+
+	return (u16)(
+		(((u16)rdram_load_u8(raw_data, address + 0ULL)) << 8) |
+		(((u16)rdram_load_u8(raw_data, address + 1ULL)) << 0)
+	);
+}
+
+static inline u32 rdram_load_u32(const u8 *restrict const raw_data, const u64 address) {
+	const u64 word_address = address & 0x7FFFFFFCULL;
+
+	if ((address & 3ULL) == 0ULL) {
+		return *(const u32 *)(raw_data + word_address);
+	}
+
+	// Unaligned word; merge the two words it straddles, just like an
+	// `lwl`/`lwr` instruction pair would on real hardware.
+	const unsigned int shift = ((unsigned int)(address & 3ULL)) * 8U;
+	const u32 high = *(const u32 *)(raw_data + word_address + 0ULL);
+	const u32 low  = *(const u32 *)(raw_data + word_address + 4ULL);
+
+	return (high << shift) | (low >> (32U - shift));
+}
+
+static inline u64 rdram_load_u64(const u8 *restrict const raw_data, const u64 address) {
+	const u64 high = (u64)rdram_load_u32(raw_data, address + 0ULL);
+	const u64 low  = (u64)rdram_load_u32(raw_data, address + 4ULL);
+
+	return (high << 32) | low;
+}
+
+static inline void rdram_store_u8(u8 *restrict const raw_data, const u64 address, const u8 value) {
+	raw_data[(address & 0x7FFFFFFFULL) ^ 3ULL] = value;
+}
+
+static inline void rdram_store_u16(u8 *restrict const raw_data, const u64 address, const u16 value) {
+	if ((address & 1ULL) == 0ULL) {
+		*(u16 *)(raw_data + ((address & 0x7FFFFFFFULL) ^ 2ULL)) = value;
+		return;
+	}
+
+	rdram_store_u8(raw_data, address + 0ULL, (u8)(value >> 8));
+	rdram_store_u8(raw_data, address + 1ULL, (u8)(value >> 0));
+}
+
+static inline void rdram_store_u32(u8 *restrict const raw_data, const u64 address, const u32 value) {
+	if ((address & 3ULL) == 0ULL) {
+		*(u32 *)(raw_data + (address & 0x7FFFFFFCULL)) = value;
+		return;
+	}
+
+	rdram_store_u8(raw_data, address + 0ULL, (u8)(value >> 24));
+	rdram_store_u8(raw_data, address + 1ULL, (u8)(value >> 16));
+	rdram_store_u8(raw_data, address + 2ULL, (u8)(value >>  8));
+	rdram_store_u8(raw_data, address + 3ULL, (u8)(value >>  0));
+}
+
+static inline void rdram_store_u64(u8 *restrict const raw_data, const u64 address, const u64 value) {
+	rdram_store_u32(raw_data, address + 0ULL, (u32)(value >> 32));
+	rdram_store_u32(raw_data, address + 4ULL, (u32)(value >>  0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A kernel that permutes the bytes within each group of `group_size`
+ *        bytes of `src` and writes the result to `dst`.
+ * @param[out] dst The destination buffer. May be unaligned.
+ * @param[in] src The source buffer. May be unaligned and may be equal to
+ *                `dst`, but must not otherwise overlap with it.
+ * @param[in] size The number of bytes to convert. Must be a multiple of the
+ *                 kernel's group size.
+ */
+typedef void (*SwizzleKernel)(u8 *dst, const u8 *src, size_t size);
+
+static inline void swizzle_bswap32_scalar(u8 *dst, const u8 *src, size_t size) {
+	for (size_t i = 0ULL; i < size; i += 4ULL) {
+		u32 word;
+		memcpy(&word, src + i, sizeof(word));
+		word = __builtin_bswap32(word);
+		memcpy(dst + i, &word, sizeof(word));
+	}
+}
+
+static inline void swizzle_hswap32_scalar(u8 *dst, const u8 *src, size_t size) {
+	for (size_t i = 0ULL; i < size; i += 4ULL) {
+		u32 word;
+		memcpy(&word, src + i, sizeof(word));
+		word = (word << 16) | (word >> 16);
+		memcpy(dst + i, &word, sizeof(word));
+	}
+}
+
+static inline void swizzle_wswap64_scalar(u8 *dst, const u8 *src, size_t size) {
+	for (size_t i = 0ULL; i < size; i += 8ULL) {
+		u64 dword;
+		memcpy(&dword, src + i, sizeof(dword));
+		dword = (dword << 32) | (dword >> 32);
+		memcpy(dst + i, &dword, sizeof(dword));
+	}
+}
+
+#if CPU_ARCH_X86
+
+// `_mm_set_epi8()` takes its arguments from the most to the least significant
+// byte, which is why the masks below are written back-to-front.
+#define SWIZZLE_MASK_BSWAP32 12, 13, 14, 15,  8,  9, 10, 11,  4,  5,  6,  7,  0,  1,  2,  3
+#define SWIZZLE_MASK_HSWAP32 13, 12, 15, 14,  9,  8, 11, 10,  5,  4,  7,  6,  1,  0,  3,  2
+#define SWIZZLE_MASK_WSWAP64 11, 10,  9,  8, 15, 14, 13, 12,  3,  2,  1,  0,  7,  6,  5,  4
+
+#define IMPL_SWIZZLE_KERNEL_SSSE3(NAME, MASK, SCALAR_FALLBACK) \
+__attribute__((__target__("ssse3"))) \
+static inline void NAME##_ssse3(u8 *dst, const u8 *src, size_t size) { \
+	const __m128i mask = _mm_set_epi8(MASK); \
+	size_t i = 0ULL; \
+	for (; (i + 16ULL) <= size; i += 16ULL) { \
+		__m128i block = _mm_loadu_si128((const __m128i *)(src + i)); \
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(block, mask)); \
+	} \
+	SCALAR_FALLBACK(dst + i, src + i, size - i); \
+}
+
+#define IMPL_SWIZZLE_KERNEL_AVX2(NAME, MASK, SCALAR_FALLBACK) \
+__attribute__((__target__("avx2"))) \
+static inline void NAME##_avx2(u8 *dst, const u8 *src, size_t size) { \
+	const __m256i mask = _mm256_set_epi8(MASK, MASK); \
+	size_t i = 0ULL; \
+	for (; (i + 64ULL) <= size; i += 64ULL) { \
+		__m256i block_0 = _mm256_loadu_si256((const __m256i *)(src + i +  0ULL)); \
+		__m256i block_1 = _mm256_loadu_si256((const __m256i *)(src + i + 32ULL)); \
+		_mm256_storeu_si256((__m256i *)(dst + i +  0ULL), _mm256_shuffle_epi8(block_0, mask)); \
+		_mm256_storeu_si256((__m256i *)(dst + i + 32ULL), _mm256_shuffle_epi8(block_1, mask)); \
+	} \
+	for (; (i + 32ULL) <= size; i += 32ULL) { \
+		__m256i block = _mm256_loadu_si256((const __m256i *)(src + i)); \
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_shuffle_epi8(block, mask)); \
+	} \
+	SCALAR_FALLBACK(dst + i, src + i, size - i); \
+}
+
+IMPL_SWIZZLE_KERNEL_SSSE3(swizzle_bswap32, SWIZZLE_MASK_BSWAP32, swizzle_bswap32_scalar)
+IMPL_SWIZZLE_KERNEL_SSSE3(swizzle_hswap32, SWIZZLE_MASK_HSWAP32, swizzle_hswap32_scalar)
+IMPL_SWIZZLE_KERNEL_SSSE3(swizzle_wswap64, SWIZZLE_MASK_WSWAP64, swizzle_wswap64_scalar)
+IMPL_SWIZZLE_KERNEL_AVX2(swizzle_bswap32, SWIZZLE_MASK_BSWAP32, swizzle_bswap32_scalar)
+IMPL_SWIZZLE_KERNEL_AVX2(swizzle_hswap32, SWIZZLE_MASK_HSWAP32, swizzle_hswap32_scalar)
+IMPL_SWIZZLE_KERNEL_AVX2(swizzle_wswap64, SWIZZLE_MASK_WSWAP64, swizzle_wswap64_scalar)
+
+#endif
+
+/**
+ * @brief Reverse the byte order of every 32-bit word. Converts between the
+ *        recomp's layout and big-endian (N64) byte order, in both directions.
+ */
+static SwizzleKernel swizzle_bswap32 = swizzle_bswap32_scalar;
+
+/**
+ * @brief Swap both halfwords of every 32-bit word. Converts between the
+ *        recomp's layout and an array of host-order `u16` values.
+ */
+static SwizzleKernel swizzle_hswap32 = swizzle_hswap32_scalar;
+
+/**
+ * @brief Swap both words of every 64-bit doubleword. Converts between the
+ *        recomp's layout and an array of host-order `u64` values.
+ */
+static SwizzleKernel swizzle_wswap64 = swizzle_wswap64_scalar;
+
+/**
+ * @brief Pick the fastest available implementation of each kernel once, when
+ *        the shared library gets loaded.
+ */
+__attribute__((__constructor__))
+static inline void swizzle_select_kernels(void) {
+#if CPU_ARCH_X86
+	const CPUFeatures features = cpu_get_features();
+
+	if (features & CPUFeatures_AVX2) {
+		swizzle_bswap32 = swizzle_bswap32_avx2;
+		swizzle_hswap32 = swizzle_hswap32_avx2;
+		swizzle_wswap64 = swizzle_wswap64_avx2;
+	} else if (features & CPUFeatures_SSSE3) {
+		swizzle_bswap32 = swizzle_bswap32_ssse3;
+		swizzle_hswap32 = swizzle_hswap32_ssse3;
+		swizzle_wswap64 = swizzle_wswap64_ssse3;
+	}
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Copy `length` bytes starting at the N64 address `address` out of
+ *        `raw_data` into `dst`, in big-endian (N64) byte order.
+ */
+static inline void rdram_read_bytes(
+		u8 *restrict const dst,
+		const u8 *restrict const raw_data,
+		u64 address,
+		size_t length
+) {
+	size_t i = 0ULL;
+
+	for (; (i < length) && ((address & 3ULL) != 0ULL); i++, address++) {
+		dst[i] = rdram_load_u8(raw_data, address);
+	}
+
+	const size_t body_length = (length - i) & ~(size_t)3ULL;
+	swizzle_bswap32(dst + i, raw_data + address, body_length);
+	i += body_length;
+	address += body_length;
+
+	for (; i < length; i++, address++) {
+		dst[i] = rdram_load_u8(raw_data, address);
+	}
+}
+
+/**
+ * @brief Like `strnlen()`, for the N64 string at the N64 address `address`.
+ *
+ * A word contains a NUL byte no matter in which order its bytes are stored,
+ * so the first word with a NUL in it can be found with `memchr()` (which libc
+ * vectorizes) directly on `raw_data`. Only within that word does the order
+ * matter.
+ */
+static inline size_t rdram_string_length(
+		const u8 *restrict const raw_data,
+		const u64 address,
+		const size_t max_length
+) {
+	size_t i = 0ULL;
+
+	for (; (i < max_length) && (((address + i) & 3ULL) != 0ULL); i++) {
+		if (rdram_load_u8(raw_data, address + i) == 0) {
+			return i;
+		}
+	}
+
+	while (i < max_length) {
+		const size_t body_length = (max_length - i) & ~(size_t)3ULL;
+		if (body_length == 0ULL) {
+			break;
+		}
+
+		const u8 *hit = (const u8 *)memchr(raw_data + address + i, 0, body_length);
+		if (hit == NULL) {
+			i += body_length;
+			break;
+		}
+
+		const size_t word_offset = (size_t)((u64)(hit - raw_data) & ~3ULL) - (size_t)address;
+		for (size_t j = 0ULL; j < 4ULL; j++) {
+			if (rdram_load_u8(raw_data, address + word_offset + j) == 0) {
+				return word_offset + j;
+			}
+		}
+
+		// Unreachable, the word contains a NUL byte by definition.
+		i = word_offset + 4ULL;
+	}
+
+	for (; i < max_length; i++) {
+		if (rdram_load_u8(raw_data, address + i) == 0) {
+			return i;
+		}
+	}
+
+	return max_length;
+}
+
+/**
+ * @brief Copy `length` big-endian (N64 order) bytes from `src` into
+ *        `raw_data`, starting at the N64 address `address`.
+ */
+static inline void rdram_write_bytes(
+		u8 *restrict const raw_data,
+		u64 address,
+		const u8 *restrict const src,
+		size_t length
+) {
+	size_t i = 0ULL;
+
+	for (; (i < length) && ((address & 3ULL) != 0ULL); i++, address++) {
+		raw_data[(address & 0x7FFFFFFFULL) ^ 3ULL] = src[i];
+	}
+
+	const size_t body_length = (length - i) & ~(size_t)3ULL;
+	swizzle_bswap32(raw_data + address, src + i, body_length);
+	i += body_length;
+	address += body_length;
+
+	for (; i < length; i++, address++) {
+		raw_data[(address & 0x7FFFFFFFULL) ^ 3ULL] = src[i];
+	}
+}
+
+/**
+ * @brief Set `length` bytes starting at the N64 address `address` to `value`.
+ */
+static inline void rdram_fill_bytes(
+		u8 *restrict const raw_data,
+		u64 address,
+		const u8 value,
+		size_t length
+) {
+	size_t i = 0ULL;
+
+	for (; (i < length) && ((address & 3ULL) != 0ULL); i++, address++) {
+		raw_data[(address & 0x7FFFFFFFULL) ^ 3ULL] = value;
+	}
+
+	// All bytes of the words in between are equal, so their order does not
+	// matter and a plain `memset()` will do.
+	const size_t body_length = (length - i) & ~(size_t)3ULL;
+	memset(raw_data + address, value, body_length);
+	i += body_length;
+	address += body_length;
+
+	for (; i < length; i++, address++) {
+		raw_data[(address & 0x7FFFFFFFULL) ^ 3ULL] = value;
+	}
+}
+
+/**
+ * @brief Copy `length` bytes from the N64 address `src` to the N64 address
+ *        `dst`, both within `raw_data`. The ranges may overlap.
+ *
+ * If both addresses share the same alignment modulo 4, their bytes occupy the
+ * same lanes of their words, so everything except the ragged edges can be
+ * moved word-at-a-time without any swizzling. Otherwise, the data is staged
+ * through a buffer in N64 byte order.
+ */
+static inline void rdram_copy_bytes(
+		u8 *restrict const raw_data,
+		const u64 dst,
+		const u64 src,
+		const size_t length
+) {
+	if ((dst == src) || (length == 0ULL)) {
+		return;
+	}
+
+	const bool is_backwards = (dst > src) && (dst < (src + length));
+
+	if (((dst ^ src) & 3ULL) == 0ULL) {
+		const size_t misalignment = (size_t)((4ULL - (dst & 3ULL)) & 3ULL);
+		const size_t head_length = misalignment < length ? misalignment : length;
+		const size_t body_length = (length - head_length) & ~(size_t)3ULL;
+		const size_t tail_length = length - head_length - body_length;
+		const u64 body_offset = (u64)head_length;
+		const u64 tail_offset = body_offset + (u64)body_length;
+
+		if (!is_backwards) {
+			for (size_t i = 0ULL; i < head_length; i++) {
+				rdram_store_u8(raw_data, dst + i, rdram_load_u8(raw_data, src + i));
+			}
+		} else {
+			for (size_t i = tail_length; i-- > 0ULL;) {
+				rdram_store_u8(raw_data, dst + tail_offset + i, rdram_load_u8(raw_data, src + tail_offset + i));
+			}
+		}
+
+		memmove(raw_data + dst + body_offset, raw_data + src + body_offset, body_length);
+
+		if (!is_backwards) {
+			for (size_t i = 0ULL; i < tail_length; i++) {
+				rdram_store_u8(raw_data, dst + tail_offset + i, rdram_load_u8(raw_data, src + tail_offset + i));
+			}
+		} else {
+			for (size_t i = head_length; i-- > 0ULL;) {
+				rdram_store_u8(raw_data, dst + i, rdram_load_u8(raw_data, src + i));
+			}
+		}
+
+		return;
+	}
+
+	// Each chunk is read completely before it is written, so overlapping
+	// ranges are fine as long as the chunks are visited in the right order.
+	u8 buffer[0x1000];
+	for (size_t done = 0ULL; done < length;) {
+		const size_t chunk_length = (length - done) < sizeof(buffer) ? (length - done) : sizeof(buffer);
+		const u64 offset = is_backwards ? (u64)(length - done - chunk_length) : (u64)done;
+		rdram_read_bytes(buffer, raw_data, src + offset, chunk_length);
+		rdram_write_bytes(raw_data, dst + offset, buffer, chunk_length);
+		done += chunk_length;
+	}
+}
+
+/**
+ * @brief Copy `count` halfwords starting at the N64 address `address` out of
+ *        `raw_data` into `dst`, in host byte order.
+ */
+static inline void rdram_read_u16_array(
+		u16 *restrict const dst,
+		const u8 *restrict const raw_data,
+		u64 address,
+		size_t count
+) {
+	size_t i = 0ULL;
+
+	if ((address & 1ULL) != 0ULL) {
+		for (; i < count; i++, address += 2ULL) {
+			dst[i] = rdram_load_u16(raw_data, address);
+		}
+		return;
+	}
+
+	if (((address & 3ULL) != 0ULL) && (i < count)) {
+		dst[i++] = rdram_load_u16(raw_data, address);
+		address += 2ULL;
+	}
+
+	const size_t body_count = (count - i) & ~(size_t)1ULL;
+	swizzle_hswap32((u8 *)(dst + i), raw_data + address, body_count * sizeof(u16));
+	i += body_count;
+	address += body_count * sizeof(u16);
+
+	if (i < count) {
+		dst[i] = rdram_load_u16(raw_data, address);
+	}
+}
+
+/**
+ * @brief Copy `count` words starting at the N64 address `address` out of
+ *        `raw_data` into `dst`, in host byte order.
+ */
+static inline void rdram_read_u32_array(
+		u32 *restrict const dst,
+		const u8 *restrict const raw_data,
+		u64 address,
+		size_t count
+) {
+	if ((address & 3ULL) == 0ULL) {
+		memcpy(dst, raw_data + address, count * sizeof(u32));
+		return;
+	}
+
+	for (size_t i = 0ULL; i < count; i++, address += 4ULL) {
+		dst[i] = rdram_load_u32(raw_data, address);
+	}
+}
+
+/**
+ * @brief Copy `count` doublewords starting at the N64 address `address` out
+ *        of `raw_data` into `dst`, in host byte order.
+ */
+static inline void rdram_read_u64_array(
+		u64 *restrict const dst,
+		const u8 *restrict const raw_data,
+		u64 address,
+		size_t count
+) {
+	if ((address & 3ULL) == 0ULL) {
+		swizzle_wswap64((u8 *)dst, raw_data + address, count * sizeof(u64));
+		return;
+	}
+
+	for (size_t i = 0ULL; i < count; i++, address += 8ULL) {
+		dst[i] = rdram_load_u64(raw_data, address);
+	}
+}
+
+#endif
@@ -0,0 +1,354 @@
+#pragma once
+
+#ifndef HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__VALUE_SCAN_H_
+#define HEADER_GUARD__SRC__SHARED__LUA_LOADER__UTILS__VALUE_SCAN_H_ 1
+
+/**
+ * A value scanner in the style of Cheat Engine: a first scan collects every
+ * address whose value satisfies a predicate, and later scans narrow that set
+ * down further, e.g. to the values that decreased since the last scan.
+ *
+ * Memory is processed in chunks of `SCAN_CHUNK_LENGTH` values. Each chunk is
+ * converted to host byte order with the swizzle kernels, tested in a
+ * branch-free loop the compiler can vectorize, and only then compacted into
+ * the result set, skipping eight non-matching values at a time.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./return.h"
+#include "./swizzle.h"
+#include "./types.h"
+
+#define SCAN_CHUNK_LENGTH 1024ULL
+
+typedef enum ScanType {
+	ScanType_s8,
+	ScanType_s16,
+	ScanType_s32,
+	ScanType_s64,
+	ScanType_u8,
+	ScanType_u16,
+	ScanType_u32,
+	ScanType_u64,
+	ScanType_f32,
+	ScanType_f64,
+	ScanType_COUNT,
+} ScanType;
+
+static const char *const scan_type_names[] = {
+	"s8", "s16", "s32", "s64", "u8", "u16", "u32", "u64", "f32", "f64", NULL,
+};
+
+static const u8 scan_type_sizes[] = {
+	1, 2, 4, 8, 1, 2, 4, 8, 4, 8,
+};
+
+typedef enum ScanPredicate {
+	// Compare against a given value
+	ScanPredicate_Equal,
+	ScanPredicate_NotEqual,
+	ScanPredicate_Less,
+	ScanPredicate_LessEqual,
+	ScanPredicate_Greater,
+	ScanPredicate_GreaterEqual,
+	// Keep everything, to compare against it on the next scan
+	ScanPredicate_Any,
+	// Compare against the value from the previous scan
+	ScanPredicate_Changed,
+	ScanPredicate_Unchanged,
+	ScanPredicate_Increased,
+	ScanPredicate_Decreased,
+	ScanPredicate_COUNT,
+} ScanPredicate;
+
+static const char *const scan_predicate_names[] = {
+	"==", "~=", "<", "<=", ">", ">=",
+	"any",
+	"changed", "unchanged", "increased", "decreased",
+	NULL,
+};
+
+static inline bool scan_predicate_needs_previous(const ScanPredicate predicate) {
+	return predicate >= ScanPredicate_Changed;
+}
+
+static inline bool scan_predicate_needs_value(const ScanPredicate predicate) {
+	return predicate < ScanPredicate_Any;
+}
+
+/**
+ * The addresses that survived all scans so far, in ascending order, along with
+ * the raw bits of their values as of the last scan.
+ */
+typedef struct ScanResultSet {
+	ScanType type;
+	size_t count;
+	size_t capacity;
+	u32 *addresses;
+	// Packed at `scan_type_sizes[type]` bytes per value, so that a `"u8"` scan
+	// does not need eight bytes for each of them.
+	u8 *values;
+} ScanResultSet;
+
+static inline void scan_result_set_free(ScanResultSet *restrict const set) {
+	free(set->addresses);
+	free(set->values);
+	set->addresses = NULL;
+	set->values = NULL;
+	set->count = 0ULL;
+	set->capacity = 0ULL;
+}
+
+static inline bool scan_result_set_reserve(ScanResultSet *restrict const set, const size_t capacity) {
+	if (capacity <= set->capacity) {
+		return true;
+	}
+
+	size_t new_capacity = (set->capacity > 0ULL) ? set->capacity : SCAN_CHUNK_LENGTH;
+	while (new_capacity < capacity) new_capacity *= 2ULL;
+
+	u32 *addresses = (u32 *)realloc(set->addresses, new_capacity * sizeof(u32));
+	if (addresses == NULL) {
+		return false;
+	}
+	set->addresses = addresses;
+
+	u8 *values = (u8 *)realloc(set->values, new_capacity * scan_type_sizes[set->type]);
+	if (values == NULL) {
+		return false;
+	}
+	set->values = values;
+
+	set->capacity = new_capacity;
+
+	return true;
+}
+
+static inline u64 scan_result_set_get_value(const ScanResultSet *restrict const set, const size_t i) {
+	switch (scan_type_sizes[set->type]) {
+		case 1:  return set->values[i];
+		case 2:  { u16 value; memcpy(&value, set->values + (i * sizeof(u16)), sizeof(u16)); return value; }
+		case 4:  { u32 value; memcpy(&value, set->values + (i * sizeof(u32)), sizeof(u32)); return value; }
+		default: { u64 value; memcpy(&value, set->values + (i * sizeof(u64)), sizeof(u64)); return value; }
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef union ScanChunk {
+	u8  u8 [SCAN_CHUNK_LENGTH];
+	u16 u16[SCAN_CHUNK_LENGTH];
+	u32 u32[SCAN_CHUNK_LENGTH];
+	u64 u64[SCAN_CHUNK_LENGTH];
+} ScanChunk;
+
+/**
+ * @brief Test every value in `current` (and `previous`) against `predicate`,
+ *        setting `matches[i]` to `1` or `0`.
+ */
+typedef void (*ScanFilter)(
+	u8 *matches,
+	const ScanChunk *current,
+	const ScanChunk *previous,
+	size_t count,
+	ScanPredicate predicate,
+	u64 value_bits
+);
+
+#define SCAN_FILTER_LOOP(CONDITION) { \
+	for (size_t i = 0ULL; i < count; i++) { \
+		matches[i] = (u8)(CONDITION); \
+	} \
+	break; \
+}
+
+#define IMPL_SCAN_FILTER(TYPENAME, RAW_TYPENAME) \
+static inline void scan_filter_##TYPENAME( \
+		u8 *restrict const matches, \
+		const ScanChunk *restrict const current, \
+		const ScanChunk *restrict const previous, \
+		const size_t count, \
+		const ScanPredicate predicate, \
+		const u64 value_bits \
+) { \
+	const RAW_TYPENAME *a = current->RAW_TYPENAME; \
+	const RAW_TYPENAME *b = (previous != NULL) ? previous->RAW_TYPENAME : a; \
+	const TYPENAME x = BIT_CAST(RAW_TYPENAME, TYPENAME, (RAW_TYPENAME)value_bits); \
+	\
+	switch (predicate) { \
+		case ScanPredicate_Equal:        SCAN_FILTER_LOOP(BIT_CAST(RAW_TYPENAME, TYPENAME, a[i]) == x) \
+		case ScanPredicate_NotEqual:     SCAN_FILTER_LOOP(BIT_CAST(RAW_TYPENAME, TYPENAME, a[i]) != x) \
+		case ScanPredicate_Less:         SCAN_FILTER_LOOP(BIT_CAST(RAW_TYPENAME, TYPENAME, a[i]) <  x) \
+		case ScanPredicate_LessEqual:    SCAN_FILTER_LOOP(BIT_CAST(RAW_TYPENAME, TYPENAME, a[i]) <= x) \
+		case ScanPredicate_Greater:      SCAN_FILTER_LOOP(BIT_CAST(RAW_TYPENAME, TYPENAME, a[i]) >  x) \
+		case ScanPredicate_GreaterEqual: SCAN_FILTER_LOOP(BIT_CAST(RAW_TYPENAME, TYPENAME, a[i]) >= x) \
+		case ScanPredicate_Any:          SCAN_FILTER_LOOP(1) \
+		/* Compare bits rather than values, so that NaNs count as unchanged. */ \
+		case ScanPredicate_Changed:      SCAN_FILTER_LOOP(a[i] != b[i]) \
+		case ScanPredicate_Unchanged:    SCAN_FILTER_LOOP(a[i] == b[i]) \
+		case ScanPredicate_Increased:    SCAN_FILTER_LOOP(BIT_CAST(RAW_TYPENAME, TYPENAME, a[i]) > BIT_CAST(RAW_TYPENAME, TYPENAME, b[i])) \
+		case ScanPredicate_Decreased:    SCAN_FILTER_LOOP(BIT_CAST(RAW_TYPENAME, TYPENAME, a[i]) < BIT_CAST(RAW_TYPENAME, TYPENAME, b[i])) \
+		default:                         SCAN_FILTER_LOOP(0) \
+	} \
+}
+
+IMPL_SCAN_FILTER(s8,  u8)
+IMPL_SCAN_FILTER(s16, u16)
+IMPL_SCAN_FILTER(s32, u32)
+IMPL_SCAN_FILTER(s64, u64)
+IMPL_SCAN_FILTER(u8,  u8)
+IMPL_SCAN_FILTER(u16, u16)
+IMPL_SCAN_FILTER(u32, u32)
+IMPL_SCAN_FILTER(u64, u64)
+IMPL_SCAN_FILTER(f32, u32)
+IMPL_SCAN_FILTER(f64, u64)
+
+static const ScanFilter scan_filters[] = {
+	scan_filter_s8,
+	scan_filter_s16,
+	scan_filter_s32,
+	scan_filter_s64,
+	scan_filter_u8,
+	scan_filter_u16,
+	scan_filter_u32,
+	scan_filter_u64,
+	scan_filter_f32,
+	scan_filter_f64,
+};
+
+static inline void scan_chunk_set(ScanChunk *restrict const chunk, const size_t type_size, const size_t i, const u64 value) {
+	switch (type_size) {
+		case 1:  chunk->u8[i]  = (u8)value;  break;
+		case 2:  chunk->u16[i] = (u16)value; break;
+		case 4:  chunk->u32[i] = (u32)value; break;
+		default: chunk->u64[i] = value;      break;
+	}
+}
+
+static inline u64 scan_load(const u8 *restrict const raw_data, const size_t type_size, const u64 address) {
+	switch (type_size) {
+		case 1:  return rdram_load_u8(raw_data, address);
+		case 2:  return rdram_load_u16(raw_data, address);
+		case 4:  return rdram_load_u32(raw_data, address);
+		default: return rdram_load_u64(raw_data, address);
+	}
+}
+
+/**
+ * @brief Find the next match at or after `i`, checking eight entries of
+ *        `matches` at a time.
+ */
+static inline size_t scan_next_match(const u8 *restrict const matches, size_t i, const size_t count) {
+	for (; (i + 8ULL) <= count; i += 8ULL) {
+		u64 block;
+		memcpy(&block, matches + i, sizeof(block));
+		if (block != 0ULL) break;
+	}
+
+	for (; (i < count) && (matches[i] == 0); i++);
+
+	return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Start a new scan over the N64 address range `[start, stop)`.
+ *
+ * Only addresses that are aligned to the size of `set->type` are considered.
+ * `predicate` must not be one that compares against a previous scan.
+ *
+ * @return `false` if allocating memory failed.
+ */
+static inline bool scan_first(
+		ScanResultSet *restrict const set,
+		const u8 *restrict const raw_data,
+		u64 start,
+		const u64 stop,
+		const ScanPredicate predicate,
+		const u64 value_bits
+) {
+	const size_t type_size = scan_type_sizes[set->type];
+	const ScanFilter filter = scan_filters[set->type];
+
+	ScanChunk chunk;
+	u8 matches[SCAN_CHUNK_LENGTH];
+
+	set->count = 0ULL;
+	start = (start + type_size - 1ULL) & ~(u64)(type_size - 1ULL);
+
+	while ((start + type_size) <= stop) {
+		size_t count = (size_t)((stop - start) / type_size);
+		if (count > SCAN_CHUNK_LENGTH) count = SCAN_CHUNK_LENGTH;
+
+		switch (type_size) {
+			case 1:  rdram_read_bytes(chunk.u8, raw_data, start, count);       break;
+			case 2:  rdram_read_u16_array(chunk.u16, raw_data, start, count);  break;
+			case 4:  rdram_read_u32_array(chunk.u32, raw_data, start, count);  break;
+			default: rdram_read_u64_array(chunk.u64, raw_data, start, count);  break;
+		}
+
+		filter(matches, &chunk, NULL, count, predicate, value_bits);
+
+		if (!scan_result_set_reserve(set, set->count + count)) {
+			return false;
+		}
+
+		for (size_t i = scan_next_match(matches, 0ULL, count); i < count; i = scan_next_match(matches, i + 1ULL, count)) {
+			set->addresses[set->count] = (u32)(start + (i * type_size));
+			memcpy(set->values + (set->count * type_size), chunk.u8 + (i * type_size), type_size);
+			set->count++;
+		}
+
+		start += count * type_size;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Narrow down the result of a previous scan, keeping only the
+ *        addresses whose current value satisfies `predicate`.
+ */
+static inline void scan_refine(
+		ScanResultSet *restrict const set,
+		const u8 *restrict const raw_data,
+		const ScanPredicate predicate,
+		const u64 value_bits
+) {
+	const size_t type_size = scan_type_sizes[set->type];
+	const ScanFilter filter = scan_filters[set->type];
+
+	ScanChunk current;
+	ScanChunk previous;
+	u8 matches[SCAN_CHUNK_LENGTH];
+
+	size_t kept = 0ULL;
+
+	for (size_t offset = 0ULL; offset < set->count; offset += SCAN_CHUNK_LENGTH) {
+		size_t count = set->count - offset;
+		if (count > SCAN_CHUNK_LENGTH) count = SCAN_CHUNK_LENGTH;
+
+		for (size_t i = 0ULL; i < count; i++) {
+			scan_chunk_set(&current, type_size, i, scan_load(raw_data, type_size, set->addresses[offset + i]));
+		}
+		memcpy(previous.u8, set->values + (offset * type_size), count * type_size);
+
+		filter(matches, &current, &previous, count, predicate, value_bits);
+
+		// `kept` never overtakes `offset + i`, so compacting in place is safe.
+		for (size_t i = scan_next_match(matches, 0ULL, count); i < count; i = scan_next_match(matches, i + 1ULL, count)) {
+			set->addresses[kept] = set->addresses[offset + i];
+			memcpy(set->values + (kept * type_size), current.u8 + (i * type_size), type_size);
+			kept++;
+		}
+	}
+
+	set->count = kept;
+}
+
+#endif
@@ -30,6 +30,31 @@ return select(2, assert(xpcall(function(...)
 	--print(Recomp.rdram:get_occupied_length())
 	--print(Recomp.call_game_func("Player_Init", 0x80841AC4, 0xA4C))
 
+	-- Round-trip checks for the `rdram` module. They only run if it can be
+	-- loaded and an earlier run of the mod wrote a raw dump and a snapshot back
+	-- to back (see the commented-out calls at the end of `test_hook()` in
+	-- `mod.c`).
+	local has_rdram_module, rdram_module = pcall(require, "rdram")
+	local dump = has_rdram_module and rdram_module.open("/tmp/rdram-dump.bin")
+	if dump then
+		for _, length in ipairs({ 0x1, 0x1000, 0x10000, 0x100000 }) do
+			local view = dump:view(0x80000000, length)
+			local compressed = view:compress()
+			if compressed ~= nil then
+				assert(#compressed < length)
+				assert(rdram_module.decompress(compressed, length) == view:to_string())
+			end
+		end
+
+		local snapshot = rdram_module.open("/tmp/rdram-snapshot.bin")
+		if snapshot then
+			assert(snapshot:get_length() == dump:get_length())
+			assert(snapshot:get_raw_data_as_string() == dump:get_raw_data_as_string())
+		end
+
+		print("rdram round-trip checks passed")
+	end
+
 	do return end
 
 	local script_dir = (debug.getinfo(1, "S").source:sub(2):match("^(.*)[/\\][^/\\]+$"))